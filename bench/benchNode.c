@@ -0,0 +1,23 @@
+//chain node of loadBench: copies "in" to "out" every tick
+//
+//build: gcc -O2 -o benchNode bench/benchNode.c nodeSystem.c
+#include "../nodeSystem.h"
+
+int main(){
+	//pipes are added before init
+	int32_t value = 0;
+	int in = nodeSystemAddPipe("in",NODE_PIPE_IN,NODE_UNIT_INT32,1,&value);
+	int out = nodeSystemAddPipe("out",NODE_PIPE_OUT,NODE_UNIT_INT32,1,&value);
+	if(in < 0 || out < 0 || nodeSystemInit() != 0 || nodeSystemBegine() != 0)
+		return -1;
+
+	while(1){
+		nodeSystemLoop();
+		nodeSystemRead(in,&value);
+		value++;
+		nodeSystemWrite(out,&value);
+		nodeSystemWait();
+	}
+
+	return 0;
+}
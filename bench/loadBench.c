@@ -0,0 +1,103 @@
+//load time against graph size: chain of N benchNode connected in->out
+//writes the save file, times nodeSystemLoad and then nodeSystemGetNodeStat on the last node
+//load time includes starting every node process: each spawn copies the manager fd table
+//(3 fds per node), so it grows faster than N; handshake, connect and level update are linear
+//
+//build: gcc -O2 -DNODE_SYSTEM_HOST -o loadBench bench/loadBench.c nodeSystem.c
+//usage: ./loadBench ./benchNode [N...]
+#include "../nodeSystem.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <limits.h>
+#include <unistd.h>
+
+//stat calls per graph size
+#define BENCH_LOOKUP 10000
+
+static double benchNow(){
+	struct timespec spec;
+	clock_gettime(CLOCK_MONOTONIC,&spec);
+	return spec.tv_sec + spec.tv_nsec / 1e9;
+}
+
+//same format as nodeSystemSave: nodes, connections, const (blank line after each)
+static int benchGenerate(const char* path,const char* nodePath,int count){
+	FILE* file = fopen(path,"w");
+	if(file == NULL)
+		return -1;
+
+	int i;
+	for(i = 0;i < count;i++)
+		fprintf(file,"%s\nnode%d\n",nodePath,i);
+	fprintf(file,"\n");
+
+	for(i = 1;i < count;i++)
+		fprintf(file,"node%d\nin\nnode%d\nout\n",i,i - 1);
+	fprintf(file,"\n\n");
+
+	return fclose(file);
+}
+
+int main(int argc,char** argv){
+	if(argc < 2){
+		fprintf(stderr,"usage: %s nodePath [N...]\n",argv[0]);
+		return 1;
+	}
+
+	static const int defaultSize[] = {100,500,1000,2000};
+	int sizeCount = argc > 2 ? argc - 2 : (int)(sizeof(defaultSize)/sizeof(defaultSize[0]));
+
+	char nodePath[PATH_MAX];
+	if(realpath(argv[1],nodePath) == NULL){
+		perror(argv[1]);
+		return 1;
+	}
+
+	if(nodeSystemInit(1) != 0)
+		return 1;
+
+	int i;
+	for(i = 0;i < sizeCount;i++){
+		int count = argc > 2 ? atoi(argv[i + 2]) : defaultSize[i];
+		char path[] = "/tmp/loadBenchXXXXXX";
+		int fd = mkstemp(path);
+		if(fd < 0 || benchGenerate(path,nodePath,count) != 0){
+			perror("save file");
+			return 1;
+		}
+		close(fd);
+
+		//load
+		double begin = benchNow();
+		nodeSystemLoad(path);
+		double load = benchNow() - begin;
+		unlink(path);
+
+		//name lookup of last node
+		char last[32];
+		sprintf(last,"node%d",count - 1);
+		NODE_STAT stat;
+		int fail = 0;
+		int n;
+		begin = benchNow();
+		for(n = 0;n < BENCH_LOOKUP;n++)
+			fail += nodeSystemGetNodeStat(last,&stat) != 0;
+		double lookup = (benchNow() - begin) / BENCH_LOOKUP;
+
+		printf("N=%-6d load %8.3fs   lookup %7.2fus%s\n",count,load,lookup * 1e6,fail ? "   (last node not found)" : "");
+		fflush(stdout);
+
+		//next size starts from empty graph
+		int nameCount;
+		char** names = nodeSystemGetNodeNameList(&nameCount);
+		for(n = 0;names != NULL && n < nameCount;n++){
+			nodeSystemKill(names[n]);
+			free(names[n]);
+		}
+		free(names);
+	}
+
+	nodeSystemExit();
+	return 0;
+}
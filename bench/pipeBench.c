@@ -0,0 +1,173 @@
+//pipe transport benchmark: one writer and N readers on one OUT pipe
+//compares default seqlock pipe with NODE_PIPE_OPT_TRIPLE
+//
+//build: gcc -O2 -o pipeBench bench/pipeBench.c
+//usage: ./pipeBench [readers] [payload bytes] [writes]
+#include "../nodeSystem.c"
+#include <inttypes.h>
+
+//reader result (shared with parent)
+typedef struct{
+	uint64_t reads;
+	uint64_t retries;	//loan returned while writer touched it
+	uint64_t fails;		//loan gave up (writer not finished)
+	uint64_t torn;		//copy was not one write (must be 0)
+	uint64_t cpu;		//reader cpu time [ns]
+}benchReader;
+
+//shared state of one run
+typedef struct{
+	volatile int start;
+	volatile int stop;
+	benchReader readers[];
+}benchShare;
+
+//cpu time of this process (wall time is shared when cores are fewer than processes)
+static uint64_t benchNow(){
+	struct timespec spec;
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID,&spec);
+	return spec.tv_sec * 1000000000ULL + spec.tv_nsec;
+}
+
+static void benchRead(shm_key* shm,size_t size,benchShare* share,benchReader* res){
+	uint8_t* buf = malloc(size);
+	while(!share->start);
+
+	uint64_t begin = benchNow();
+	while(!share->stop){
+		uint64_t loan;
+		int ret;
+		do{
+			//same loop as pipeMemoryRead, counting retries
+			void* mem = pipeMemoryLoan(shm,size,0,&loan,NULL);
+			if(mem == NULL){
+				res->fails++;
+				ret = -1;
+				break;
+			}
+			memcpy(buf,mem,size);
+			ret = pipeMemoryReturn(shm,size,0,loan);
+			if(ret == 1)
+				res->retries++;
+		}while(ret == 1);
+
+		if(ret != 0)
+			continue;
+
+		//every byte of one write is the same
+		res->reads++;
+		if(memcmp(buf,buf + 1,size - 1) != 0)
+			res->torn++;
+	}
+	res->cpu = benchNow() - begin;
+
+	free(buf);
+}
+
+//writes a reader can hold a loan across before it is torn
+static int benchLap(uint8_t mode){
+	size_t size = 64;
+	size_t memSize = PIPE_HEAD_SIZE + PIPE_SLOT_SIZE(size) * 3;
+	uint8_t buf[64] = {};
+	pipeHead* head = calloc(1,memSize);
+	head->version = PIPE_HEAD_VERSION;
+	head->mode = mode;
+	head->back = 1;
+	shm_key shm = {.shmMap = head,.size = memSize};
+
+	uint64_t loan;
+	pipeMemoryWrite(&shm,buf,size);
+	pipeMemoryLoan(&shm,size,0,&loan,NULL);
+
+	int laps = 0;
+	do{
+		pipeMemoryWrite(&shm,buf,size);
+		laps++;
+	}while(pipeMemoryReturn(&shm,size,0,loan) == 0 && laps < 16);
+
+	free(head);
+	return laps;
+}
+
+static int benchRun(const char* name,uint8_t mode,int readerCount,size_t size,uint64_t writes){
+	//pipe memory (same layout as manager: header and payload)
+	size_t memSize = PIPE_HEAD_SIZE + (mode == PIPE_MODE_TRIPLE ? PIPE_SLOT_SIZE(size) * 3 : size);
+	void* map = mmap(NULL,memSize,PROT_READ | PROT_WRITE,MAP_SHARED | MAP_ANONYMOUS,-1,0);
+	benchShare* share = mmap(NULL,sizeof(benchShare) + sizeof(benchReader) * readerCount,
+		PROT_READ | PROT_WRITE,MAP_SHARED | MAP_ANONYMOUS,-1,0);
+	if(map == MAP_FAILED || share == MAP_FAILED){
+		perror("mmap");
+		return -1;
+	}
+
+	//init header as pipeMemoryInit does
+	pipeHead* head = map;
+	head->version = PIPE_HEAD_VERSION;
+	head->mode = mode;
+	head->latest = 0;
+	head->back = 1;
+
+	shm_key shm = {.shmMap = map,.size = memSize};
+
+	//readers
+	int i;
+	int* pids = malloc(sizeof(int) * readerCount);
+	for(i = 0;i < readerCount;i++){
+		pids[i] = fork();
+		if(pids[i] == 0){
+			benchRead(&shm,size,share,&share->readers[i]);
+			_exit(0);
+		}
+	}
+
+	//writer
+	uint8_t* buf = malloc(size);
+	share->start = 1;
+	uint64_t begin = benchNow();
+	uint64_t n;
+	for(n = 0;n < writes;n++){
+		memset(buf,(int)n,size);
+		pipeMemoryWrite(&shm,buf,size);
+	}
+	uint64_t elapsed = benchNow() - begin;
+	share->stop = 1;
+
+	for(i = 0;i < readerCount;i++)
+		waitpid(pids[i],NULL,0);
+
+	//report
+	benchReader sum = {};
+	for(i = 0;i < readerCount;i++){
+		sum.reads += share->readers[i].reads;
+		sum.retries += share->readers[i].retries;
+		sum.fails += share->readers[i].fails;
+		sum.torn += share->readers[i].torn;
+		sum.cpu += share->readers[i].cpu;
+	}
+	printf("%-8s write %8.1f ns  read %8.1f ns  reads %10" PRIu64 "  retry/1k %6.2f  fail %4" PRIu64 "  torn %" PRIu64 "\n",name,
+		(double)elapsed / writes,sum.reads ? (double)sum.cpu / sum.reads : 0.0,sum.reads,
+		sum.reads ? sum.retries * 1000.0 / sum.reads : 0.0,sum.fails,sum.torn);
+
+	free(buf);
+	free(pids);
+	munmap(share,sizeof(benchShare) + sizeof(benchReader) * readerCount);
+	munmap(map,memSize);
+	return 0;
+}
+
+int main(int argc,char** argv){
+	int readerCount = argc > 1 ? atoi(argv[1]) : 3;
+	size_t size = argc > 2 ? strtoul(argv[2],NULL,0) : 4096;
+	uint64_t writes = argc > 3 ? strtoull(argv[3],NULL,0) : 1000000;
+	if(readerCount < 0 || size < 2 || writes == 0){
+		fprintf(stderr,"usage: %s [readers] [payload bytes] [writes]\n",argv[0]);
+		return 1;
+	}
+
+	printf("reader torn by write: seqlock %d, triple %d\n",benchLap(PIPE_MODE_SEQLOCK),benchLap(PIPE_MODE_TRIPLE));
+	printf("readers %d  payload %zu bytes  writes %" PRIu64 "\n",readerCount,size,writes);
+	benchRun("seqlock",PIPE_MODE_SEQLOCK,readerCount,size,writes);
+	benchRun("triple",PIPE_MODE_TRIPLE,readerCount,size,writes);
+
+	return 0;
+}
@@ -1,12 +1,16 @@
+#define _GNU_SOURCE
 #include "nodeSystem.h"
 #include <stdlib.h>
 #include <stdint.h>
+#include <inttypes.h>
 #include <string.h>
 #include <unistd.h>
 #include <signal.h>
 #include <sys/ipc.h>
 #include <sys/shm.h>
 #include <sys/sem.h>
+#include <sys/mman.h>
+#include <semaphore.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <fcntl.h>
@@ -14,6 +18,16 @@
 #include <errno.h>
 #include <time.h>
 #include <stdarg.h>
+#include <sched.h>
+#include <limits.h>
+#include <sys/syscall.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
+#include <sys/wait.h>
+#include <sys/uio.h>
+#include <spawn.h>
+#include <linux/futex.h>
 #include <linux/limits.h>
 #ifdef NODE_SYSTEM_HOST
 #include <linear_list.h>
@@ -28,25 +42,162 @@ typedef struct
 	int shmId;
 	int semId;
 	void* shmMap;
+	uint8_t backend;
+	int ownerPid;
+	int memFd;
+	size_t size;
+	uint64_t offset;
 }shm_key;
 
+//key backend of memory carved out of pipe arena
+#define SHM_ARENA 0x10
+
+//memfd prefix (process shared semaphore)
+#define SHM_PREFIX_SIZE 64
+_Static_assert(sizeof(sem_t) <= SHM_PREFIX_SIZE,"semaphore is too large");
+
+//huge page size
+#define SHM_HUGE_PAGE_SIZE (2*1024*1024)
+
+//pipe write stamp
+typedef struct{
+	uint64_t sequence;
+	uint64_t timestamp;
+	uint64_t tick;
+}pipeStamp;
+
+//pipe memory header
+typedef struct{
+	uint32_t seq;		//futex word of readers
+	uint16_t version;
+	uint8_t mode;
+	uint8_t back;
+	uint16_t depth;
+	uint32_t latest;
+	uint32_t waiters;	//readers sleeping on seq
+	uint64_t index;
+	uint64_t sequence;
+	pipeStamp stamp;
+}pipeHead;
+
+//stream and triple buffer slot header
+typedef struct{
+	uint64_t seq;
+	pipeStamp stamp;
+}pipeSlot;
+
+//pipe writer metrics (semaphore wait is updated under the lock)
+typedef struct{
+	uint64_t writes;
+	uint64_t bytes;
+	uint64_t lockCount;
+	uint64_t lockWaitSum;	//[ns]
+	uint64_t lockWaitMax;	//[ns]
+}pipeWriteMetric;
+
+//pipe reader metrics (sum of every reader)
+typedef struct{
+	uint64_t reads;
+	uint64_t bytes;
+	uint64_t unchanged;	//reads that saw no new write
+	uint64_t skipped;	//writes never seen by the reader
+}pipeReadMetric;
+
+//pipe header version
+#define PIPE_HEAD_VERSION 3
+
+//pipe transport mode
+enum _pipeMode{
+	PIPE_MODE_SEQLOCK = 0,
+	PIPE_MODE_SEMAPHORE = 1,
+	PIPE_MODE_STREAM = 2,
+	PIPE_MODE_TRIPLE = 3
+};
+
+//pipe header size (header, writer and reader metrics and payload on own cache line)
+#define PIPE_LINE_SIZE 64
+#define PIPE_HEAD_SIZE (PIPE_LINE_SIZE*3)
+_Static_assert(sizeof(pipeHead) <= PIPE_LINE_SIZE,"pipe header is too large");
+_Static_assert(sizeof(pipeWriteMetric) <= PIPE_LINE_SIZE,"pipe metric is too large");
+_Static_assert(sizeof(pipeReadMetric) <= PIPE_LINE_SIZE,"pipe metric is too large");
+#define PIPE_WRITE_METRIC(map) ((pipeWriteMetric*)((void*)(map) + PIPE_LINE_SIZE))
+#define PIPE_READ_METRIC(map) ((pipeReadMetric*)((void*)(map) + PIPE_LINE_SIZE*2))
+#define PIPE_DATA(map) ((void*)(map) + PIPE_HEAD_SIZE)
+
+//stream slot size and address
+#define PIPE_SLOT_SIZE(size) ((sizeof(pipeSlot) + (size) + 7) & ~(size_t)7)
+#define PIPE_SLOT(map,size,n) ((pipeSlot*)(PIPE_DATA(map) + PIPE_SLOT_SIZE(size) * (n)))
+
+//retry count of seqlock reader
+#define PIPE_READ_SPIN 64
+#define PIPE_READ_RETRY 100000
+
+//wait slice of futex fallback [ns]
+#define PIPE_WAIT_SLICE 1000000
+
 //system global value
 typedef struct{
 	uint8_t isNoLog;
+	uint8_t shmBackend;
+	uint32_t event;		//futex word bumped by control message
 	time_t timeOffset;
 	double period;
 } nodeSystemEnv;
 
+//timer statistics [ns]
+typedef struct{
+	uint64_t ticks;
+	uint64_t missed;
+	uint64_t lateSum;
+	uint64_t lateMax;
+	uint64_t jitterSum;
+	uint64_t jitterMax;
+}timerStat;
+
+//log-linear histogram: 8 sub buckets per power of two [ns] (error < 12.5%, up to 17s)
+#define HIST_SUB_BITS 3
+#define HIST_BUCKETS 256
+
+//wakeup slot of one node
+typedef struct{
+	int pid;			//0 until node is activated
+	uint32_t divisor;	//woken every divisor ticks (0: free slot)
+	uint32_t level;		//topological level in pipe graph
+	uint32_t wake;		//wake count by timer
+	uint32_t done;		//wake count at last nodeSystemWait (0: never reported)
+	uint64_t deadline;	//completion deadline of last wake [ns]
+	uint64_t overrun;	//ticks fired while node was still running
+	uint64_t lateMax;	//worst completion after deadline [ns]
+	uint64_t wakeTime;	//SIGCONT time of last wake [ns]
+	uint64_t execMax;	//worst wake to nodeSystemWait [ns]
+	uint64_t wakeupMax;	//worst SIGCONT to resume [ns]
+	uint32_t execHist[HIST_BUCKETS];	//written by node only
+	uint32_t wakeupHist[HIST_BUCKETS];
+}wakeupSlot;
+
+//wakeup table shared with timer process and nodes
+#define WAKEUP_NODE_MAX 4096
+typedef struct{
+	int isRun;
+	uint8_t policy;
+	uint32_t count;		//slot high-water mark
+	uint32_t levels;	//number of topological levels
+	uint32_t doneCount;	//futex word bumped by node at nodeSystemWait
+	uint32_t waiting;	//timer sleeps on doneCount
+	uint64_t tick;		//base tick index
+	timerStat stat;
+	wakeupSlot nodes[WAKEUP_NODE_MAX];
+}wakeupTable;
+
 
 //local lib func
 static char* getRealTimeStr();
 static int debugPrintf(const char* fmt,...);
-static int fileRead(   int fd,void* buf,ssize_t size);
-static int fileReadStr(int fd,char* str,ssize_t size);
 static int fileReadWithTimeOut(   int fd,void* buf,ssize_t size,uint32_t usec);
 static int fileReadStrWithTimeOut(int fd,char* str,ssize_t size,uint32_t usec);
 static int fileWrite(   int fd,const void* buf,ssize_t size);
 static int fileWriteStr(int fd,const char* str);
+static int fileWait(int fd,short events,const struct timespec* limit);
 static int shareMemoryGenerate(size_t size,shm_key* shm);
 static int shareMemoryDeleate(shm_key* shm);
 static int shareMemoryOpen(shm_key* shm,int shmFlag);
@@ -55,17 +206,24 @@ static int shareMemoryRead(shm_key* shm,void* buf,size_t size);
 static int shareMemoryWrite(shm_key* shm,void* buf,size_t size);
 static int shareMemoryLock(shm_key* shm);
 static int shareMemoryUnLock(shm_key* shm);
+static int pipeMemoryRead(shm_key* shm,void* buf,size_t size,pipeStamp* stamp);
+static int pipeMemoryWrite(shm_key* shm,const void* buf,size_t size);
+static void* pipeMemoryLoan(shm_key* shm,size_t size,uint8_t isWrite,uint64_t* seq,pipeStamp* stamp);
+static int pipeMemoryReturn(shm_key* shm,size_t size,uint8_t isWrite,uint64_t seq);
+static int pipeMemoryWake(pipeHead* head);
 
 //global
 static FILE* logFile;
 static shm_key systemSettingKey;
 static nodeSystemEnv* systemSettingMemory = NULL;
+static shm_key pipeArena;
+static uint64_t tickCount = 0;
 
 //適当マジックナンバー　破滅的な変更のたびに変えて行く
-static const uint32_t _node_init_head = 0x83DFC690;
-static const uint32_t _node_init_eof  = 0x85CBADEF;
-static const uint32_t _node_begin_head = 0x9067F3A2;
-static const uint32_t _node_begin_eof  = 0x910AC8BB;
+static const uint32_t _node_init_head = 0x8B41E2D7;
+static const uint32_t _node_init_eof  = 0x8C9A0F35;
+static const uint32_t _node_begin_head = 0x9A2C47B1;
+static const uint32_t _node_begin_eof  = 0x9B7E1D06;
 
 #ifdef NODE_SYSTEM_HOST
 
@@ -87,7 +245,21 @@ enum _pipeHead{
 	PIPE_TIMER_GET = 13,
 	PIPE_EXIT = 14,
 	PIPE_KILL = 15,
-	PIPE_CHECK_FILE = 16
+	PIPE_CHECK_FILE = 16,
+	PIPE_TIMER_POLICY = 17,
+	PIPE_TIMER_STAT = 18,
+	PIPE_TIMER_DIVISOR = 19,
+	PIPE_TIMER_SCHED = 20,
+	PIPE_NODE_STAT = 21,
+	PIPE_GET_PIPE_STAT = 22,
+	PIPE_RESOLVE = 23,
+	PIPE_HANDLE_CONNECT = 24,
+	PIPE_HANDLE_DISCONNECT = 25,
+	PIPE_HANDLE_SET_CONST = 26,
+	PIPE_HANDLE_GET_CONST = 27,
+	PIPE_HANDLE_KILL = 28,
+	PIPE_BATCH = 29,
+	PIPE_SET_ENV = 30
 };
 
 typedef struct{
@@ -95,8 +267,13 @@ typedef struct{
 	uint16_t length;
 	NODE_PIPE_TYPE type;
 	NODE_DATA_UNIT unit;
+	uint8_t option;
+	uint16_t depth;
 	char* connectNode;
 	char* connectPipe;
+	uint16_t mergeCount;
+	char** mergeNode;
+	char** mergePipe;
 	shm_key shm;
 }nodePipe;
 
@@ -105,8 +282,27 @@ typedef struct{
 	int fd[3];
 	char* name;
 	char* filePath;
+	uint32_t divisor;
+	int slot;
+	char* cpuList;
+	uint8_t policy;
+	int priority;
+	double runtime;
+	char** env;			//"NAME=VALUE" over manager environment ("-env")
+	uint16_t envCount;
+	char* errBuffer;	//stderr ring buffer (allocated at first output)
+	size_t errHead;
+	size_t errLen;
+	uint64_t errDropped;
+	int errFd;			//stderr log file (-1: discard)
+	uint8_t isActive;	//handshake is done
+	uint8_t startPhase;	//NODE_START_*
+	uint64_t startTime;	//spawn time [ns]
+	int order;			//scratch index of nodeLevelUpdate
 	uint16_t pipeCount;
 	nodePipe* pipes;
+	uint16_t* pipeIndex;	//hash of pipe name (pipe number + 1, 0: empty)
+	uint16_t pipeIndexSize;
 }nodeData;
 
 typedef struct{
@@ -114,12 +310,87 @@ typedef struct{
 	void (*func)();
 }node_op;
 
+//sched_setattr argment (SCHED_DEADLINE)
+typedef struct{
+	uint32_t size;
+	uint32_t policy;
+	uint64_t flags;
+	int32_t nice;
+	uint32_t priority;
+	uint64_t runtime;
+	uint64_t deadline;
+	uint64_t period;
+}schedAttr;
+
+//free block of pipe arena
+typedef struct{
+	size_t offset;
+	size_t size;
+}arenaBlock;
+
 //local func
-static void nodeSystemLoop();
+static int nodeSystemLoop();
+static void timerLoop(int parent);
+static void timerWaitDone(wakeupTable* table,const uint32_t* slots,uint32_t count,uint64_t limit);
+static void nodeLevelUpdate();
+static int schedApply(int pid,const char* name,const char* cpuList,uint8_t policy,int priority,double runtime,double period);
 static int nodeBegin(nodeData* node);
 static void nodeDeleate(nodeData* node);
 static int receiveNodeProperties(nodeData* node);
-static int popenRWasNonBlock(const char const * command,int* fd);
+static int receiveNodeHead(nodeData* node);
+static int receiveNodePipes(nodeData* node);
+static nodeData* nodeSpawn();
+static void nodeStartFail(nodeData* node);
+static int nodeStartWait(nodeData** nodes,int* results,int count,uint8_t until);
+static void nodeActivate(nodeData* node);
+static int popenRWasNonBlock(const char* command,char* const* argv,char* const* envp,int* fd);
+static char** nodeEnvBuild(nodeData* node);
+static void optionWrite(FILE* file,uint8_t* isFirst,const char* name,const char* value);
+static char* optionToken(char** cursor);
+static int arenaGenerate(size_t size,shm_key* shm);
+static int arenaDeleate(shm_key* shm);
+static int pipeMemoryInit(shm_key* shm,uint8_t mode,uint16_t depth);
+static int shareMemorySendKey(int fd,shm_key* shm);
+static void nodeEventNotify();
+static uint64_t histPercentile(const uint32_t* hist,double rate,uint64_t max);
+static int ctrlWrite(const void* buf,size_t size);
+static int ctrlWriteStr(const char* str);
+static int ctrlFlush();
+static int ctrlRead(void* buf,size_t size);
+static int ctrlReadStr(char* str,size_t size);
+static int ctrlReadWithTimeOut(void* buf,size_t size,uint32_t usec);
+static void ctrlSkip(size_t size);
+static int ctrlReceive(void* buf,size_t size,uint8_t isStr,int64_t usec);
+static void nodeReap();
+static void nodeErrDrain(nodeData* node);
+static void nodeErrPoll();
+static void nodeErrFlush(nodeData* node);
+static void nodeErrFlushAll();
+static int eventAdd(int epoll,int eventFd,nodeData* node,uint8_t kind);
+static uint32_t nameHash(const char* name);
+static nodeData* nodeFind(const char* name);
+static int nodeIndexAdd(nodeData* node);
+static void nodeIndexRemove(nodeData* node);
+static int pipeIndexBuild(nodeData* node);
+static nodePipe* pipeFind(const char* nodeName,const char* pipeName,nodeData** node,uint16_t* index);
+static NODE_HANDLE handleMake(nodeData* node,int pipe);
+static nodeData* handleFind(NODE_HANDLE handle,uint16_t* pipe);
+static char** constReceive(int* retCode);
+static int nodeConnect(nodeData* node_in,uint16_t pipe_in,nodeData* node_out,uint16_t pipe_out);
+static int nodeDisConnect(nodeData* node_in,uint16_t pipe_in);
+static int constRead(nodePipe* pipe_const,int count);
+static void constSend(nodePipe* pipe_const);
+static void nodeKill(nodeData* node);
+static uint8_t batchEnter();
+static int batchLeave();
+static void batchSwap();
+static int connectReceive();
+static int disConnectReceive();
+static int constSetReceive();
+static int constLoadReceive();
+static int handleConnectReceive();
+static int handleDisConnectReceive();
+static int handleConstSetReceive();
 
 static void pipeAddNode();
 static void pipeNodeList();
@@ -133,10 +404,24 @@ static void pipeTimerRun();
 static void pipeTimerStop();
 static void pipeTimerSet();
 static void pipeTimerGet();
+static void pipeTimerPolicy();
+static void pipeTimerStat();
+static void pipeTimerDivisor();
+static void pipeTimerSched();
+static void pipeNodeStat();
 static void pipeKill();
 static void pipeCheckFile();
 static void pipeGetNodeNameList();
 static void pipeGetPipeNameList();
+static void pipeGetPipeStat();
+static void pipeResolve();
+static void pipeHandleConnect();
+static void pipeHandleDisConnect();
+static void pipeHandleSetConst();
+static void pipeHandleGetConst();
+static void pipeHandleKill();
+static void pipeBatch();
+static void pipeSetEnv();
 static void pipeExit();
 
 //op list
@@ -157,7 +442,21 @@ static const node_op opTable[] = {
 	{.op=PIPE_TIMER_GET			,.func=pipeTimerGet},
 	{.op=PIPE_EXIT				,.func=pipeExit},
 	{.op=PIPE_KILL				,.func=pipeKill},
-	{.op=PIPE_CHECK_FILE		,.func=pipeCheckFile}
+	{.op=PIPE_CHECK_FILE		,.func=pipeCheckFile},
+	{.op=PIPE_TIMER_POLICY		,.func=pipeTimerPolicy},
+	{.op=PIPE_TIMER_STAT		,.func=pipeTimerStat},
+	{.op=PIPE_TIMER_DIVISOR		,.func=pipeTimerDivisor},
+	{.op=PIPE_TIMER_SCHED		,.func=pipeTimerSched},
+	{.op=PIPE_NODE_STAT			,.func=pipeNodeStat},
+	{.op=PIPE_GET_PIPE_STAT		,.func=pipeGetPipeStat},
+	{.op=PIPE_RESOLVE			,.func=pipeResolve},
+	{.op=PIPE_HANDLE_CONNECT	,.func=pipeHandleConnect},
+	{.op=PIPE_HANDLE_DISCONNECT	,.func=pipeHandleDisConnect},
+	{.op=PIPE_HANDLE_SET_CONST	,.func=pipeHandleSetConst},
+	{.op=PIPE_HANDLE_GET_CONST	,.func=pipeHandleGetConst},
+	{.op=PIPE_HANDLE_KILL		,.func=pipeHandleKill},
+	{.op=PIPE_BATCH				,.func=pipeBatch},
+	{.op=PIPE_SET_ENV			,.func=pipeSetEnv}
 };
 
 //const value
@@ -165,11 +464,72 @@ static const char logRootPath[] = "./Logs";
 
 //global value
 static int pid;
+static int timerPid;
 static int fd[2];
 static char* logFolder;
 static nodeData** activeNodeList = NULL;
 static nodeData** inactiveNodeList = NULL;
 static shm_key wakeupNodeArray;
+static uint8_t shmBackend = NODE_SHM_SYSV;
+static size_t arenaSize = 64*1024*1024;
+static arenaBlock* arenaFreeList = NULL;
+static int arenaFreeCount = 0;
+static int epollFd = -1;
+static int errEpollFd = -1;	//stderr of every node (nested in epollFd)
+static int signalFd = -1;
+static size_t logBufferSize = 64*1024;
+static uint8_t logDropPolicy = NODE_LOG_DROP_OLDEST;
+static uint8_t logPending = 0;
+static uint64_t logFlushTime = 0;
+static nodeData** nodeIndex = NULL;	//hash of node name (open addressing)
+static uint32_t nodeIndexSize = 0;
+static uint32_t nodeIndexCount = 0;
+static nodeData* handleNode[WAKEUP_NODE_MAX];	//active node of wakeup slot
+static uint32_t handleGen[WAKEUP_NODE_MAX];		//bumped when slot is released
+
+//events handled per epoll_wait
+#define NODE_EVENT_MAX 64
+
+//kind of epoll event, in low bits of epoll data with owner node (NULL: manager, EVENT_NODE_ERR: errEpollFd)
+enum{
+	EVENT_CTRL = 0,
+	EVENT_SIGNAL = 1,
+	EVENT_NODE_BEGIN = 2,
+	EVENT_NODE_ERR = 3
+};
+#define EVENT_KIND_MASK 3
+_Static_assert(_Alignof(nodeData) > EVENT_KIND_MASK,"node pointer has no room for event kind");
+
+//stderr buffer is written to log after this time at latest [ms]
+#define NODE_LOG_FLUSH_MS 100
+
+//starting nodes have to make progress within this time [ms]
+#define NODE_START_TIMEOUT_MS 1000
+
+//start phase of node
+enum{
+	NODE_START_HEAD = 0,		//waiting init header
+	NODE_START_PROPERTY = 1,	//waiting pipe properties
+	NODE_START_BEGIN = 2,		//waiting nodeSystemBegine (inactive list)
+	NODE_START_DONE = 3			//active or failed
+};
+
+//control frame (uint32_t payload length + payload)
+#define CTRL_FRAME_HEAD sizeof(uint32_t)
+static uint8_t* ctrlOut = NULL;
+static size_t ctrlOutSize = 0;
+static size_t ctrlOutCap = 0;
+static uint8_t ctrlIn[64*1024];
+static size_t ctrlInPos = 0;
+static size_t ctrlInLen = 0;
+static uint32_t ctrlInFrame = 0;	//payload left in current frame
+
+//batch queue (frame built aside ctrlOut between nodeSystemBatchBegin and Commit)
+static uint8_t* batchOut = NULL;
+static size_t batchOutSize = 0;
+static size_t batchOutCap = 0;
+static uint32_t batchCount = 0;
+static uint8_t isBatch = 0;
 
 int nodeSystemInit(uint8_t isNoLog){
 	//set logfile
@@ -195,6 +555,8 @@ int nodeSystemInit(uint8_t isNoLog){
 
 	//set env data
 	systemSettingMemory->isNoLog = isNoLog;
+	systemSettingMemory->shmBackend = shmBackend;
+	systemSettingMemory->event = 0;
 	systemSettingMemory->period = 1000.0;
 
 	//copy data
@@ -255,44 +617,32 @@ int nodeSystemInit(uint8_t isNoLog){
 		activeNodeList = LINEAR_LIST_CREATE(nodeData*);
 		inactiveNodeList = LINEAR_LIST_CREATE(nodeData*);
 
+		//map pipe arena once
+		if(arenaSize != 0){
+			if(shareMemoryGenerate(arenaSize,&pipeArena) == 0 && shareMemoryOpen(&pipeArena,0) == 0){
+				arenaFreeList = malloc(sizeof(arenaBlock));
+				arenaFreeList[0].offset = 0;
+				arenaFreeList[0].size = arenaSize;
+				arenaFreeCount = 1;
+			}else{
+				memset(&pipeArena,0,sizeof(pipeArena));
+			}
+		}
+
 		//fork timer thread
-		shareMemoryGenerate(sizeof(int)*4096,&wakeupNodeArray);
+		shareMemoryGenerate(sizeof(wakeupTable),&wakeupNodeArray);
 		shareMemoryOpen(&wakeupNodeArray,0);
-		memset(wakeupNodeArray.shmMap,0,sizeof(int)*4096);
+		memset(wakeupNodeArray.shmMap,0,sizeof(wakeupTable));
+		((wakeupTable*)wakeupNodeArray.shmMap)->levels = 1;
 		pid = fork();
 		if(pid == 0){
 			logFile = NULL;
-			pid = getppid();
-			struct timespec interval = {};
-			int* pidList = wakeupNodeArray.shmMap;
-			shareMemoryOpen(&systemSettingKey,SHM_RDONLY);
-			while(kill(pid,0) == 0){
-				shareMemoryLock(&systemSettingKey);
-				nodeSystemEnv* env = systemSettingKey.shmMap;
-				long nsec = env->period * 1000000LL;
-				interval.tv_sec = nsec/1000000000LL;
-				interval.tv_nsec = nsec%1000000000LL;
-				shareMemoryUnLock(&systemSettingKey);
-
-				shareMemoryLock(&wakeupNodeArray);
-				if(pidList[0]){
-					int i;
-					for(i = 1;pidList[i] != 0;i++){
-						kill(pidList[i],SIGCONT);
-					}
-					shareMemoryUnLock(&wakeupNodeArray);
-					nanosleep(&interval,NULL);
-				}else{
-					shareMemoryUnLock(&wakeupNodeArray);
-					nanosleep(&interval,NULL);
-				}
-			}
-			shareMemoryClose(&systemSettingKey);
-			shareMemoryDeleate(&wakeupNodeArray);
+			timerLoop(getppid());
 			exit(0);
 		}else if(pid < 0){
 			exit(1);
 		}
+		timerPid = pid;
 
 		//set log file
 		logFile = NULL;
@@ -309,11 +659,23 @@ int nodeSystemInit(uint8_t isNoLog){
 			debugPrintf("%s(): nodeSystem is activate.",__func__);
 		}
 
+		//wait control message, node handshake and SIGCHLD
+		sigset_t mask;
+		sigemptyset(&mask);
+		sigaddset(&mask,SIGCHLD);
+		sigprocmask(SIG_BLOCK,&mask,NULL);
+		signalFd = signalfd(-1,&mask,SFD_NONBLOCK | SFD_CLOEXEC);
+		epollFd = epoll_create1(EPOLL_CLOEXEC);
+		errEpollFd = epoll_create1(EPOLL_CLOEXEC);
+		if(signalFd < 0 || epollFd < 0 || errEpollFd < 0 || eventAdd(epollFd,fd[0],NULL,EVENT_CTRL) != 0 ||
+			eventAdd(epollFd,signalFd,NULL,EVENT_SIGNAL) != 0 || eventAdd(epollFd,errEpollFd,NULL,EVENT_NODE_ERR) != 0){
+			debugPrintf("%s(): failed create event loop: %s",__func__,strerror(errno));
+			exit(-1);
+		}
+
 		//loop
 		int parent = getppid();
-		while(kill(parent,0) == 0){
-			nodeSystemLoop();
-		}
+		while(kill(parent,0) == 0 && nodeSystemLoop() == 0);
 
 		//exit 
 		pipeExit();
@@ -323,6 +685,44 @@ int nodeSystemInit(uint8_t isNoLog){
 }
 
 
+int nodeSystemSetShmBackend(NODE_SHM_BACKEND backend){
+	//check
+	if(systemSettingMemory != NULL){
+		debugPrintf("%s(): nodeSystemInit() has already been executed",__func__);
+		return -1;
+	}
+
+	shmBackend = backend;
+	return 0;
+}
+
+int nodeSystemSetArenaSize(size_t size){
+	//check
+	if(systemSettingMemory != NULL){
+		debugPrintf("%s(): nodeSystemInit() has already been executed",__func__);
+		return -1;
+	}
+
+	arenaSize = size;
+	return 0;
+}
+
+int nodeSystemSetLogBuffer(size_t size,NODE_LOG_DROP policy){
+	//check
+	if(systemSettingMemory != NULL){
+		debugPrintf("%s(): nodeSystemInit() has already been executed",__func__);
+		return -1;
+	}
+	if(size == 0){
+		debugPrintf("%s(): invalid argment",__func__);
+		return -1;
+	}
+
+	logBufferSize = size;
+	logDropPolicy = policy;
+	return 0;
+}
+
 int nodeSystemAddNode(char* path,char** args){
 
 	//check argment
@@ -331,40 +731,74 @@ int nodeSystemAddNode(char* path,char** args){
 		return -1;
 	}
 	
-	//count args
+	//count args (manager reads each arg into PATH_MAX)
 	uint16_t c = 0;
-	while(args[c] != NULL)
+	while(args[c] != NULL){
+		if(strlen(args[c]) >= PATH_MAX){
+			debugPrintf("%s(): arg %d is longer than %d",__func__,c,PATH_MAX - 1);
+			return -1;
+		}
 		c++;
+	}
+
+	uint8_t isQueued = batchEnter();
 
 	//send message head
 	uint8_t head = PIPE_ADD_NODE;
-	fileWrite(fd[1],&head,sizeof(head));
+	ctrlWrite(&head,sizeof(head));
 	
 	//send execute path
-	fileWriteStr(fd[1],path);
+	ctrlWriteStr(path);
 
 	//send args count
-	fileWrite(fd[1],&c,sizeof(c));
+	ctrlWrite(&c,sizeof(c));
 
 	//send args
 	int i;
 	for(i = 0;i < c;i++){
-		fileWriteStr(fd[1],args[i]);
+		ctrlWriteStr(args[i]);
 	}
 
+	if(isQueued)
+		return batchLeave();
+
 	//wait result
 	int res = 0;
-	fileRead(fd[0],&res,sizeof(res));
+	ctrlRead(&res,sizeof(res));
 
 	return res;
 }
 
+int nodeSystemSetEnv(char* const name,char* const value){
+	//check argment
+	if(!name || name[0] == '\0' || strchr(name,'=')){
+		debugPrintf("%s(): invalid argment",__func__);
+		return -1;
+	}
+
+	//send message head
+	uint8_t head = PIPE_SET_ENV;
+	ctrlWrite(&head,sizeof(head));
+
+	//send name and value (NULL: unset)
+	uint8_t isSet = (value != NULL);
+	ctrlWriteStr(name);
+	ctrlWrite(&isSet,sizeof(isSet));
+	if(isSet)
+		ctrlWriteStr(value);
+
+	//wait result
+	int res = -1;
+	ctrlRead(&res,sizeof(res));
+
+	return res;
+}
 
 void nodeSystemPrintNodeList(int* argc,char** args){
 
 	//send message head
 	uint8_t head = PIPE_NODE_LIST;
-	fileWrite(fd[1],&head,sizeof(head));
+	ctrlWrite(&head,sizeof(head));
 
 	nodeData** itr;
 	//print active list
@@ -372,7 +806,7 @@ void nodeSystemPrintNodeList(int* argc,char** args){
 					"--------------------active node list--------------------\n");
 
 	uint16_t activeNodeCount;
-	fileRead(fd[0],&activeNodeCount,sizeof(activeNodeCount));
+	ctrlRead(&activeNodeCount,sizeof(activeNodeCount));
 	
 
 	int i;
@@ -386,10 +820,10 @@ void nodeSystemPrintNodeList(int* argc,char** args){
 					"|------------------------------------------");
 		
 		//receive node name
-		fileReadStr(fd[0],name,sizeof(name));
+		ctrlReadStr(name,sizeof(name));
 
 		//receive node file
-		fileReadStr(fd[0],filePath,sizeof(filePath));
+		ctrlReadStr(filePath,sizeof(filePath));
 
 		//print node anme and path
 		fprintf(stdout,"\n"
@@ -399,7 +833,7 @@ void nodeSystemPrintNodeList(int* argc,char** args){
 		
 		//receive pipe count
 		uint16_t pipeCount;
-		fileRead(fd[0],&pipeCount,sizeof(pipeCount));
+		ctrlRead(&pipeCount,sizeof(pipeCount));
 
 		int j;
 		for(j = 0;j < pipeCount;j++){
@@ -408,12 +842,12 @@ void nodeSystemPrintNodeList(int* argc,char** args){
 			char pipeName[PATH_MAX];
 
 			//receive pipe name
-			fileReadStr(fd[0],pipeName,sizeof(pipeName));
+			ctrlReadStr(pipeName,sizeof(pipeName));
 
 			//receive node type
-			fileRead(fd[0],&data.type,sizeof(data.type));
-			fileRead(fd[0],&data.unit,sizeof(data.unit));
-			fileRead(fd[0],&data.length,sizeof(data.length));
+			ctrlRead(&data.type,sizeof(data.type));
+			ctrlRead(&data.unit,sizeof(data.unit));
+			ctrlRead(&data.length,sizeof(data.length));
 
 			//print pipe name and type
 			fprintf(stdout,"|\n"
@@ -425,19 +859,22 @@ void nodeSystemPrintNodeList(int* argc,char** args){
 					,NODE_DATA_UNIT_STR[data.unit],(int)data.length);
 			
 			//receive state
-			uint8_t isConnected = 0;
-			fileRead(fd[0],&isConnected,sizeof(isConnected));
+			uint16_t connectCount = 0;
+			ctrlRead(&connectCount,sizeof(connectCount));
 
-			if(isConnected){
+			int k;
+			for(k = 0;k < connectCount;k++){
 				//recive connect node and pipe name
-				fileReadStr(fd[0],nodeName,sizeof(nodeName));
-				fileReadStr(fd[0],pipeName,sizeof(pipeName));
+				ctrlReadStr(nodeName,sizeof(nodeName));
+				ctrlReadStr(pipeName,sizeof(pipeName));
 
 				//print pipe name and type
 				fprintf(stdout,
 					"|\tConnected to %s of %s\n"
 					,pipeName,nodeName);
-			}else if(data.type == NODE_PIPE_IN){
+			}
+			
+			if(connectCount == 0 && (data.type == NODE_PIPE_IN || data.type == NODE_PIPE_MERGE)){
 				//print pipe name and type
 				fprintf(stdout,
 					"|\tnot Connected\n");
@@ -455,86 +892,265 @@ void nodeSystemPrintNodeList(int* argc,char** args){
 }
 
 int nodeSystemConnect(char* const inNode,char* const inPipe,char* const outNode,char* const outPipe){
+	uint8_t isQueued = batchEnter();
 	
 	//send message head
 	uint8_t head = PIPE_NODE_CONNECT;
-	fileWrite(fd[1],&head,sizeof(head));
+	ctrlWrite(&head,sizeof(head));
 	
 	//send in pipe
-	fileWriteStr(fd[1],inNode);
-	fileWriteStr(fd[1],inPipe);
+	ctrlWriteStr(inNode);
+	ctrlWriteStr(inPipe);
 
 	//send out pipe
-	fileWriteStr(fd[1],outNode);
-	fileWriteStr(fd[1],outPipe);
+	ctrlWriteStr(outNode);
+	ctrlWriteStr(outPipe);
+
+	if(isQueued)
+		return batchLeave();
 
 	//wait result
 	int res = 0;
-	fileRead(fd[0],&res,sizeof(res));
+	ctrlRead(&res,sizeof(res));
 
 	return res;
 }
 
 int nodeSystemDisConnect(char* const inNode,char* const inPipe){
+	uint8_t isQueued = batchEnter();
 	
 	//send message head
 	uint8_t head = PIPE_NODE_DISCONNECT;
-	fileWrite(fd[1],&head,sizeof(head));
+	ctrlWrite(&head,sizeof(head));
 	
 	//send  in pipe
-	fileWriteStr(fd[1],inNode);
-	fileWriteStr(fd[1],inPipe);
+	ctrlWriteStr(inNode);
+	ctrlWriteStr(inPipe);
+
+	if(isQueued)
+		return batchLeave();
 
 	//wait result
 	int res = 0;
-	fileRead(fd[0],&res,sizeof(res));
+	ctrlRead(&res,sizeof(res));
 
 	return res;
 }
 
 int nodeSystemSetConst(char* const constNode,char* const constPipe,int valueCount,char** setValue){
+	uint8_t isQueued = batchEnter();
 	
 	//send message head
 	uint8_t head = PIPE_NODE_SET_CONST;
-	fileWrite(fd[1],&head,sizeof(head));
+	ctrlWrite(&head,sizeof(head));
 	
 	//send const pipe
-	fileWriteStr(fd[1],constNode);
-	fileWriteStr(fd[1],constPipe);
+	ctrlWriteStr(constNode);
+	ctrlWriteStr(constPipe);
 
 	//send const len
-	fileWrite(fd[1],&valueCount,sizeof(valueCount));
+	ctrlWrite(&valueCount,sizeof(valueCount));
+
+	int i;
+	if(isQueued){
+		//value follows without handshake in batch
+		for(i = 0;i < valueCount;i++)
+			ctrlWriteStr(setValue[i]);
+		return batchLeave();
+	}
 
 	//get result
 	int res = 0;
-	fileRead(fd[0],&res,sizeof(res));
+	ctrlRead(&res,sizeof(res));
 	if(res != 0)
 		return res;
 
-	int i;
 	for(i = 0;i < valueCount;i++){
 		//send value
-		fileWriteStr(fd[1],setValue[i]);
+		ctrlWriteStr(setValue[i]);
+	}
+
+	//get result
+	ctrlRead(&res,sizeof(res));
+
+	return res;
+}
+
+NODE_HANDLE nodeSystemResolve(char* const nodeName,char* const pipeName){
+
+	//send message head
+	uint8_t head = PIPE_RESOLVE;
+	ctrlWrite(&head,sizeof(head));
+
+	//send node name and pipe name
+	ctrlWriteStr(nodeName);
+	ctrlWriteStr(pipeName ? pipeName : "");
+
+	//receive handle
+	NODE_HANDLE handle = 0;
+	ctrlRead(&handle,sizeof(handle));
+
+	return handle;
+}
+
+int nodeSystemConnectHandle(NODE_HANDLE inPipe,NODE_HANDLE outPipe){
+	uint8_t isQueued = batchEnter();
+
+	//send message head
+	uint8_t head = PIPE_HANDLE_CONNECT;
+	ctrlWrite(&head,sizeof(head));
+
+	//send handle
+	ctrlWrite(&inPipe,sizeof(inPipe));
+	ctrlWrite(&outPipe,sizeof(outPipe));
+
+	if(isQueued)
+		return batchLeave();
+
+	//wait result
+	int res = -1;
+	ctrlRead(&res,sizeof(res));
+
+	return res;
+}
+
+int nodeSystemDisConnectHandle(NODE_HANDLE inPipe){
+	uint8_t isQueued = batchEnter();
+
+	//send message head
+	uint8_t head = PIPE_HANDLE_DISCONNECT;
+	ctrlWrite(&head,sizeof(head));
+
+	//send handle
+	ctrlWrite(&inPipe,sizeof(inPipe));
+
+	if(isQueued)
+		return batchLeave();
+
+	//wait result
+	int res = -1;
+	ctrlRead(&res,sizeof(res));
+
+	return res;
+}
+
+int nodeSystemSetConstHandle(NODE_HANDLE constPipe,int valueCount,char** setValue){
+	uint8_t isQueued = batchEnter();
+
+	//send message head
+	uint8_t head = PIPE_HANDLE_SET_CONST;
+	ctrlWrite(&head,sizeof(head));
+
+	//send handle, count and value at once (one round trip)
+	ctrlWrite(&constPipe,sizeof(constPipe));
+	ctrlWrite(&valueCount,sizeof(valueCount));
+	int i;
+	for(i = 0;i < valueCount;i++){
+		ctrlWriteStr(setValue[i]);
+	}
+
+	if(isQueued)
+		return batchLeave();
+
+	//wait result
+	int res = -1;
+	ctrlRead(&res,sizeof(res));
+
+	return res;
+}
+
+int nodeSystemLoadConst(char* const constNode,char* const constPipe,const void* data,int size){
+	//check argment (nothing is queued on error)
+	if(!constNode || !constPipe || size < 0 || (size > 0 && !data)){
+		debugPrintf("%s(): invalid argment",__func__);
+		return -1;
 	}
 
+	uint8_t isQueued = batchEnter();
+
+	//send message head
+	uint8_t head = PIPE_LOAD;
+	ctrlWrite(&head,sizeof(head));
+
+	//send node name and piepe name
+	ctrlWriteStr(constNode);
+	ctrlWriteStr(constPipe);
+
+	//send data
+	uint32_t length = size;
+	ctrlWrite(&length,sizeof(length));
+	ctrlWrite(data,length);
+
+	if(isQueued)
+		return batchLeave();
+
 	//get result
-	fileRead(fd[0],&res,sizeof(res));
+	int res = -1;
+	ctrlRead(&res,sizeof(res));
 
 	return res;
 }
 
+int nodeSystemBatchBegin(){
+	if(isBatch){
+		debugPrintf("%s(): batch is already open",__func__);
+		return -1;
+	}
+
+	//head and count are filled at commit
+	isBatch = 1;
+	batchCount = 0;
+	batchSwap();
+	uint8_t head = PIPE_BATCH;
+	ctrlWrite(&head,sizeof(head));
+	ctrlWrite(&batchCount,sizeof(batchCount));
+	batchSwap();
+
+	return 0;
+}
+
+int nodeSystemBatchCommit(int* results,int maxCount){
+	if(!isBatch){
+		debugPrintf("%s(): batch is not open",__func__);
+		return -1;
+	}
+
+	//send queued operations as one message
+	isBatch = 0;
+	memcpy(batchOut + CTRL_FRAME_HEAD + sizeof(uint8_t),&batchCount,sizeof(batchCount));
+	batchSwap();
+	int res = ctrlFlush();
+	batchSwap();
+	if(res != 0)
+		return -1;
+
+	//receive per operation result
+	uint32_t count = 0;
+	if(ctrlRead(&count,sizeof(count)) != sizeof(count))
+		return -1;
+	uint32_t i;
+	for(i = 0;i < count;i++){
+		int tmp = -1;
+		ctrlRead(&tmp,sizeof(tmp));
+		if(results && i < maxCount)
+			results[i] = tmp;
+	}
+
+	return count;
+}
+
 int nodeSystemSave(char* const path){
 	
 	//send message head
 	uint8_t head = PIPE_SAVE;
-	fileWrite(fd[1],&head,sizeof(head));
+	ctrlWrite(&head,sizeof(head));
 	
 	//send const pipe
-	fileWriteStr(fd[1],path);
+	ctrlWriteStr(path);
 
 	//get result
 	int res = 0;
-	fileRead(fd[0],&res,sizeof(res));
+	ctrlRead(&res,sizeof(res));
 
 	return res;
 }
@@ -548,11 +1164,23 @@ int nodeSystemLoad(char* const path){
 		return -1;
 	}
 
+	//nodes start together, then connect and const are applied in the same batch
+	if(nodeSystemBatchBegin() != 0){
+		fclose(loadFile);
+		return -1;
+	}
+	uint32_t opCount = 0;
+
 	//run nodes
+	char nodePath[4096];
+	uint8_t isPending = 0;
 	while(1){
-		//get node path
-		char nodePath[4096];
-		if(fgets(nodePath,sizeof(nodePath),loadFile) != nodePath || nodePath[0] == '\n'){
+		//get node path (may be read ahead as option line)
+		if(!isPending && fgets(nodePath,sizeof(nodePath),loadFile) != nodePath){
+			break;
+		}
+		isPending = 0;
+		if(nodePath[0] == '\n'){
 			break;
 		}
 
@@ -560,6 +1188,7 @@ int nodeSystemLoad(char* const path){
 		char nodeName[4096];
 		if(fgets(nodeName,sizeof(nodeName),loadFile) != nodeName || nodeName[0] == '\n'){
 			debugPrintf("%s(): failed load node name",__func__);
+			nodeSystemBatchCommit(NULL,0);
 			fclose(loadFile);
 			return -1;
 		}
@@ -568,13 +1197,44 @@ int nodeSystemLoad(char* const path){
 		nodePath[strlen(nodePath)-1] = '\0';
 		nodeName[strlen(nodeName)-1] = '\0';
 		debugPrintf("loading node \nname:%s\npath:%s",nodeName,nodePath);
-		
-		char* args[4] = {nodePath,"-name",nodeName,NULL};
-		int code = nodeSystemAddNode(nodePath,args);
-		
-		if(code  != 0)
-			debugPrintf("load node failed");
+
+		char** args = malloc(sizeof(char*) * 4);
+		int argsCount = 0;
+		args[argsCount++] = nodePath;
+		args[argsCount++] = "-name";
+		args[argsCount++] = nodeName;
+		args[argsCount] = NULL;
+
+		//get launch option (line starts with '-', quoted values may hold space)
+		char* nodeOption = NULL;
+		size_t optionSize = 0;
+		if(getline(&nodeOption,&optionSize,loadFile) > 0){
+			if(nodeOption[0] == '-'){
+				char* cursor = nodeOption;
+				char* tok;
+				while((tok = optionToken(&cursor)) != NULL){
+					args = realloc(args,sizeof(char*) * (argsCount + 2));
+					args[argsCount++] = tok;
+				}
+				args[argsCount] = NULL;
+			}else{
+				//next node path or separator
+				isPending = 1;
+			}
+		}
+
+		nodeSystemAddNode(nodePath,args);
+		opCount++;
+
+		if(isPending){
+			if(strlen(nodeOption) >= sizeof(nodePath))
+				debugPrintf("%s(): node path is truncated to %d",__func__,(int)sizeof(nodePath) - 1);
+			snprintf(nodePath,sizeof(nodePath),"%s",nodeOption);
+		}
+		free(nodeOption);
+		free(args);
 	};
+	uint32_t nodeCount = opCount;
 
 	//connect pipe
 	while(1){
@@ -588,6 +1248,7 @@ int nodeSystemLoad(char* const path){
 		char pipeName[4096];
 		if(fgets(pipeName,sizeof(pipeName),loadFile) != pipeName || pipeName[0] == '\n'){
 			debugPrintf("%s(): failed load pipe name",__func__);
+			nodeSystemBatchCommit(NULL,0);
 			fclose(loadFile);
 			return -1;
 		}
@@ -596,6 +1257,7 @@ int nodeSystemLoad(char* const path){
 		char connectNodeName[4096];
 		if(fgets(connectNodeName,sizeof(connectNodeName),loadFile) != connectNodeName || connectNodeName[0] == '\n'){
 			debugPrintf("%s(): failed load connect node name",__func__);
+			nodeSystemBatchCommit(NULL,0);
 			fclose(loadFile);
 			return -1;
 		}
@@ -604,6 +1266,7 @@ int nodeSystemLoad(char* const path){
 		char connectPipeName[4096];
 		if(fgets(connectPipeName,sizeof(connectPipeName),loadFile) != connectPipeName || connectPipeName[0] == '\n'){
 			debugPrintf("%s(): failed load connect pipe name",__func__);
+			nodeSystemBatchCommit(NULL,0);
 			fclose(loadFile);
 			return -1;
 		}
@@ -615,11 +1278,10 @@ int nodeSystemLoad(char* const path){
 		connectPipeName[strlen(connectPipeName)-1] = '\0';
 		debugPrintf("load pipe connection \ninNode:%s\ninPipe:%s\noutNode:%s\noutPipe:%s",nodeName,pipeName,connectNodeName,connectPipeName);
 		
-		int code = nodeSystemConnect(nodeName,pipeName,connectNodeName,connectPipeName);
-		
-		if(code  != 0)
-			debugPrintf("load node connection failed");
+		nodeSystemConnect(nodeName,pipeName,connectNodeName,connectPipeName);
+		opCount++;
 	};
+	uint32_t connectCount = opCount;
 
 	//set const
 	while(1){
@@ -633,6 +1295,7 @@ int nodeSystemLoad(char* const path){
 		char pipeName[4096];
 		if(fgets(pipeName,sizeof(pipeName),loadFile) != pipeName || pipeName[0] == '\n'){
 			debugPrintf("%s(): failed load const node name",__func__);
+			nodeSystemBatchCommit(NULL,0);
 			fclose(loadFile);
 			return -1;
 		}
@@ -641,47 +1304,57 @@ int nodeSystemLoad(char* const path){
 		char dataLength[4096];
 		if(fgets(dataLength,sizeof(dataLength),loadFile) != dataLength || dataLength[0] == '\n'){
 			debugPrintf("%s(): failed load const array length",__func__);
+			nodeSystemBatchCommit(NULL,0);
 			fclose(loadFile);
 			return -1;
 		}
 
 		int size;
-		sscanf(dataLength,"%d",&size);
+		if(sscanf(dataLength,"%d",&size) != 1 || size < 0){
+			debugPrintf("%s(): invalid const array length",__func__);
+			nodeSystemBatchCommit(NULL,0);
+			fclose(loadFile);
+			return -1;
+		}
 
-		//get connect pipe name
-		void* mem = malloc(size);
-		fread(mem,size,1,loadFile);
+		//get const data
+		void* mem = malloc(size ? size : 1);
+		if(mem == NULL || fread(mem,1,size,loadFile) != size){
+			debugPrintf("%s(): failed load const array",__func__);
+			free(mem);
+			nodeSystemBatchCommit(NULL,0);
+			fclose(loadFile);
+			return -1;
+		}
 
 		//print name and path
 		nodeName[strlen(nodeName)-1] = '\0';
 		pipeName[strlen(pipeName)-1] = '\0';
 
 		debugPrintf("load const pipe \nNode:%s\nPipe:%s",nodeName,pipeName);
-	
-		//send message head
-		uint8_t head = PIPE_LOAD;
-		fileWrite(fd[1],&head,sizeof(head));
-
-		//send node name and piepe name
-		fileWriteStr(fd[1],nodeName);
-		fileWriteStr(fd[1],pipeName);
-
-		//send data
-		fileWrite(fd[1],&size,sizeof(size));
-		fileWrite(fd[1],mem,size);
-
-		//get result
-		int code;
-		fileRead(fd[0],&code,sizeof(code));
+		if(nodeSystemLoadConst(nodeName,pipeName,mem,size) == 0)
+			opCount++;
 
 		free(mem);
-
-		if(code  != 0)
-			debugPrintf("load const array failed");
 	};
 
 	fclose(loadFile);
 
+	//apply batch
+	int* results = malloc(sizeof(int) * (opCount ? opCount : 1));
+	int count = nodeSystemBatchCommit(results,opCount);
+	if(count < 0){
+		free(results);
+		return -1;
+	}
+
+	uint32_t i;
+	for(i = 0;i < count && i < opCount;i++){
+		if(results[i] != 0)
+			debugPrintf(i < nodeCount ? "load node failed" : i < connectCount ? "load node connection failed" : "load const array failed");
+	}
+	free(results);
+
 	return 0;
 }
 
@@ -689,15 +1362,31 @@ char** nodeSystemGetConst(char* const constNode,char* const constPipe,int* retCo
 	
 	//send message head
 	uint8_t head = PIPE_NODE_GET_CONST;
-	fileWrite(fd[1],&head,sizeof(head));
+	ctrlWrite(&head,sizeof(head));
 	
 	//send const pipe
-	fileWriteStr(fd[1],constNode);
-	fileWriteStr(fd[1],constPipe);
+	ctrlWriteStr(constNode);
+	ctrlWriteStr(constPipe);
+
+	return constReceive(retCode);
+}
+
+char** nodeSystemGetConstHandle(NODE_HANDLE constPipe,int* retCode){
+	
+	//send message head
+	uint8_t head = PIPE_HANDLE_GET_CONST;
+	ctrlWrite(&head,sizeof(head));
 
+	//send handle
+	ctrlWrite(&constPipe,sizeof(constPipe));
+
+	return constReceive(retCode);
+}
+
+static char** constReceive(int* retCode){
 	//receive count
-	fileRead(fd[0],retCode,sizeof(*retCode));
-	if(retCode < 0)
+	ctrlRead(retCode,sizeof(*retCode));
+	if(*retCode < 0)
 		return NULL;
 
 	//malloc mem
@@ -707,7 +1396,7 @@ char** nodeSystemGetConst(char* const constNode,char* const constPipe,int* retCo
 	for(i = 0;i < *retCode;i++){
 		//receive value
 		values[i] = malloc(256);
-		fileReadStr(fd[0],values[i],256);
+		ctrlReadStr(values[i],256);
 	}
 
 	return values;
@@ -719,7 +1408,8 @@ void nodeSystemTimerRun(){
 	
 	//send message head
 	uint8_t head = PIPE_TIMER_RUN;
-	fileWrite(fd[1],&head,sizeof(head));
+	ctrlWrite(&head,sizeof(head));
+	ctrlFlush();
 }
 
 void nodeSystemTimerStop(){
@@ -728,7 +1418,8 @@ void nodeSystemTimerStop(){
 	
 	//send message head
 	uint8_t head = PIPE_TIMER_STOP;
-	fileWrite(fd[1],&head,sizeof(head));
+	ctrlWrite(&head,sizeof(head));
+	ctrlFlush();
 }
 
 void nodeSystemTimerSet(double period){
@@ -736,10 +1427,11 @@ void nodeSystemTimerSet(double period){
 
 	//send message head
 	uint8_t head = PIPE_TIMER_SET;
-	fileWrite(fd[1],&head,sizeof(head));
+	ctrlWrite(&head,sizeof(head));
 	
 	//send period
-	fileWrite(fd[1],&period,sizeof(period));
+	ctrlWrite(&period,sizeof(period));
+	ctrlFlush();
 }
 
 void nodeSystemTimerGet(){
@@ -747,203 +1439,1437 @@ void nodeSystemTimerGet(){
 
 	//send message head
 	uint8_t head = PIPE_TIMER_GET;
-	fileWrite(fd[1],&head,sizeof(head));
+	ctrlWrite(&head,sizeof(head));
 
 	//receive period
-	fileRead(fd[0],&period,sizeof(period));
+	ctrlRead(&period,sizeof(period));
 
 	fprintf(stdout,"Timer period is %lfms\n",period);
 }
 
-int nodeSystemKill(char* const killNode){
+void nodeSystemTimerSetPolicy(NODE_TIMER_POLICY policy){
+	fprintf(stdout,"Timer policy set to %s\n",NODE_TIMER_POLICY_STR[policy]);
+
 	//send message head
-	uint8_t head = PIPE_KILL;
-	fileWrite(fd[1],&head,sizeof(head));
+	uint8_t head = PIPE_TIMER_POLICY;
+	ctrlWrite(&head,sizeof(head));
 
-	fileWriteStr(fd[1],killNode);
+	//send policy
+	uint8_t tmp = policy;
+	ctrlWrite(&tmp,sizeof(tmp));
+	ctrlFlush();
 }
 
-int nodeSystemCheck(char* const path){
+int nodeSystemTimerSetDivisor(char* const nodeName,uint32_t divisor){
+	//check argment
+	if(!nodeName || divisor == 0){
+		debugPrintf("%s(): invalid argment",__func__);
+		return -1;
+	}
+
 	//send message head
-	uint8_t head = PIPE_CHECK_FILE;
-	fileWrite(fd[1],&head,sizeof(head));
+	uint8_t head = PIPE_TIMER_DIVISOR;
+	ctrlWrite(&head,sizeof(head));
 
-	fileWriteStr(fd[1],path);
+	//send node name and divisor
+	ctrlWriteStr(nodeName);
+	ctrlWrite(&divisor,sizeof(divisor));
 
 	//wait result
-	int res = 0;
-	fileRead(fd[0],&res,sizeof(res));
+	int res = -1;
+	ctrlRead(&res,sizeof(res));
 
 	return res;
 }
 
-char** nodeSystemGetNodeNameList(int* counts){
-	
+int nodeSystemTimerSetSched(char* const cpuList,NODE_SCHED_POLICY policy,int priority){
 	//send message head
-	uint8_t head = PIPE_GET_NODE_NAME_LIST;
-	fileWrite(fd[1],&head,sizeof(head));
-	
-	//receive node count
-	uint16_t nodeCounts;
-	fileRead(fd[0],&nodeCounts,sizeof(nodeCounts));
-	
-	//malloc name list
-	char** names = malloc(sizeof(char*) * nodeCounts);
+	uint8_t head = PIPE_TIMER_SCHED;
+	ctrlWrite(&head,sizeof(head));
 
-	int i;
-	for(i = 0;i < nodeCounts;i++){
-		names[i] = malloc(PATH_MAX);
-		fileReadStr(fd[0],names[i],PATH_MAX);
-	}
+	//send cpu list and policy
+	uint8_t tmp = policy;
+	ctrlWriteStr(cpuList ? cpuList : "");
+	ctrlWrite(&tmp,sizeof(tmp));
+	ctrlWrite(&priority,sizeof(priority));
 
-	*counts = nodeCounts;
-	return names;
+	//wait result
+	int res = -1;
+	ctrlRead(&res,sizeof(res));
+
+	return res;
 }
 
-char** nodeSystemGetPipeNameList(char* nodeName,int* counts){
-	
+int nodeSystemTimerGetStat(NODE_TIMER_STAT* stat){
+	//check argment
+	if(!stat){
+		return -1;
+	}
+
 	//send message head
-	uint8_t head = PIPE_GET_PIPE_NAME_LIST;
-	fileWrite(fd[1],&head,sizeof(head));
+	uint8_t head = PIPE_TIMER_STAT;
+	ctrlWrite(&head,sizeof(head));
 
-	//send node name
-	fileWriteStr(fd[1],nodeName);
-	
-	//receive pipe count
-	uint16_t pipeCounts;
-	fileRead(fd[0],&pipeCounts,sizeof(pipeCounts));
-	
-	//malloc name list
-	char** names = malloc(sizeof(char*) * pipeCounts);
+	//receive statistics
+	timerStat tmp;
+	if(ctrlRead(&tmp,sizeof(tmp)) != sizeof(tmp))
+		return -1;
 
-	int i;
-	for(i = 0;i < pipeCounts;i++){
-		names[i] = malloc(PATH_MAX);
-		fileReadStr(fd[0],names[i],PATH_MAX);
-	}
+	//ns to ms
+	stat->ticks = tmp.ticks;
+	stat->missed = tmp.missed;
+	stat->lateAvg = tmp.ticks ? tmp.lateSum / 1000000.0 / tmp.ticks : 0;
+	stat->lateMax = tmp.lateMax / 1000000.0;
+	stat->jitterAvg = tmp.ticks > 1 ? tmp.jitterSum / 1000000.0 / (tmp.ticks - 1) : 0;
+	stat->jitterMax = tmp.jitterMax / 1000000.0;
 
-	counts[0] = pipeCounts;
+	return 0;
+}
+
+int nodeSystemKill(char* const killNode){
+	//send message head
+	uint8_t head = PIPE_KILL;
+	ctrlWrite(&head,sizeof(head));
+
+	ctrlWriteStr(killNode);
+	return ctrlFlush();
+}
+
+int nodeSystemKillHandle(NODE_HANDLE killNode){
+	//send message head
+	uint8_t head = PIPE_HANDLE_KILL;
+	ctrlWrite(&head,sizeof(head));
+
+	//send handle
+	ctrlWrite(&killNode,sizeof(killNode));
+
+	//wait result (stale handle is reported)
+	int res = -1;
+	ctrlRead(&res,sizeof(res));
+
+	return res;
+}
+
+int nodeSystemCheck(char* const path){
+	//send message head
+	uint8_t head = PIPE_CHECK_FILE;
+	ctrlWrite(&head,sizeof(head));
+
+	ctrlWriteStr(path);
+
+	//wait result
+	int res = 0;
+	ctrlRead(&res,sizeof(res));
+
+	return res;
+}
+
+int nodeSystemGetNodeStat(char* const nodeName,NODE_STAT* stat){
+	//check argment
+	if(!nodeName || !stat){
+		debugPrintf("%s(): invalid argment",__func__);
+		return -1;
+	}
+
+	//send message head
+	uint8_t head = PIPE_NODE_STAT;
+	ctrlWrite(&head,sizeof(head));
+
+	//send node name
+	ctrlWriteStr(nodeName);
+
+	//receive result and slot
+	int res = -1;
+	wakeupSlot slot;
+	ctrlRead(&res,sizeof(res));
+	ctrlRead(&slot,sizeof(slot));
+	if(res != 0)
+		return res;
+
+	stat->wakes = slot.wake;
+	stat->overruns = slot.overrun;
+	stat->lateMax = slot.lateMax / 1000000.0;
+	stat->execP50 = histPercentile(slot.execHist,0.50,slot.execMax) / 1000000.0;
+	stat->execP99 = histPercentile(slot.execHist,0.99,slot.execMax) / 1000000.0;
+	stat->execMax = slot.execMax / 1000000.0;
+	stat->wakeupP50 = histPercentile(slot.wakeupHist,0.50,slot.wakeupMax) / 1000000.0;
+	stat->wakeupP99 = histPercentile(slot.wakeupHist,0.99,slot.wakeupMax) / 1000000.0;
+	stat->wakeupMax = slot.wakeupMax / 1000000.0;
+
+	return 0;
+}
+
+char** nodeSystemGetNodeNameList(int* counts){
+	
+	//send message head
+	uint8_t head = PIPE_GET_NODE_NAME_LIST;
+	ctrlWrite(&head,sizeof(head));
+	
+	//receive node count
+	uint16_t nodeCounts;
+	ctrlRead(&nodeCounts,sizeof(nodeCounts));
+	
+	//malloc name list
+	char** names = malloc(sizeof(char*) * nodeCounts);
+
+	int i;
+	for(i = 0;i < nodeCounts;i++){
+		names[i] = malloc(PATH_MAX);
+		ctrlReadStr(names[i],PATH_MAX);
+	}
+
+	*counts = nodeCounts;
+	return names;
+}
+
+char** nodeSystemGetPipeNameList(char* nodeName,int* counts){
+	
+	//send message head
+	uint8_t head = PIPE_GET_PIPE_NAME_LIST;
+	ctrlWrite(&head,sizeof(head));
+
+	//send node name
+	ctrlWriteStr(nodeName);
+	
+	//receive pipe count
+	uint16_t pipeCounts;
+	ctrlRead(&pipeCounts,sizeof(pipeCounts));
+	
+	//malloc name list
+	char** names = malloc(sizeof(char*) * pipeCounts);
+
+	int i;
+	for(i = 0;i < pipeCounts;i++){
+		names[i] = malloc(PATH_MAX);
+		ctrlReadStr(names[i],PATH_MAX);
+	}
+
+	counts[0] = pipeCounts;
 	return names;
 }
 
+int nodeSystemGetPipeStat(char* const nodeName,char* const pipeName,NODE_PIPE_STAT* stat){
+	//check argment
+	if(!nodeName || !pipeName || !stat){
+		debugPrintf("%s(): invalid argment",__func__);
+		return -1;
+	}
+
+	//send message head
+	uint8_t head = PIPE_GET_PIPE_STAT;
+	ctrlWrite(&head,sizeof(head));
+
+	//send pipe
+	ctrlWriteStr(nodeName);
+	ctrlWriteStr(pipeName);
+
+	//receive result and metrics
+	int res = -1;
+	pipeWriteMetric write;
+	pipeReadMetric read;
+	ctrlRead(&res,sizeof(res));
+	ctrlRead(&write,sizeof(write));
+	ctrlRead(&read,sizeof(read));
+	if(res != 0)
+		return res;
+
+	stat->writes = write.writes;
+	stat->writeBytes = write.bytes;
+	stat->reads = read.reads;
+	stat->readBytes = read.bytes;
+	stat->unchanged = read.unchanged;
+	stat->skipped = read.skipped;
+	stat->lockCount = write.lockCount;
+	stat->lockWaitTotal = write.lockWaitSum / 1000000.0;
+	stat->lockWaitMax = write.lockWaitMax / 1000000.0;
+
+	return 0;
+}
+
 void nodeSystemExit(){
 	//send message head
 	uint8_t head = PIPE_EXIT;
-	fileWrite(fd[1],&head,sizeof(head));
+	ctrlWrite(&head,sizeof(head));
 
 	int res;
-	fileReadWithTimeOut(fd[0],&res,sizeof(res),5000000LL);
+	ctrlReadWithTimeOut(&res,sizeof(res),5000000LL);
+}
+
+static int nodeSystemLoop(){
+	//sleep until something happens (buffered stderr is flushed in time)
+	struct epoll_event events[NODE_EVENT_MAX];
+	int count = epoll_wait(epollFd,events,NODE_EVENT_MAX,logPending ? NODE_LOG_FLUSH_MS : -1);
+	if(count < 0){
+		if(errno == EINTR)
+			return 0;
+		debugPrintf("%s(): epoll_wait(): %s",__func__,strerror(errno));
+		return -1;
+	}
+
+	//write stderr of every node in one batch
+	if(logPending){
+		struct timespec spec;
+		clock_gettime(CLOCK_MONOTONIC,&spec);
+		uint64_t now = spec.tv_sec * 1000ULL + spec.tv_nsec / 1000000;
+		if(count == 0 || now - logFlushTime >= NODE_LOG_FLUSH_MS){
+			nodeErrFlushAll();
+			logFlushTime = now;
+		}
+	}
+
+	//stderr first: every node of this batch is alive until it is drained
+	int e;
+	for(e = 0;e < count;e++){
+		if((uintptr_t)events[e].data.ptr == EVENT_NODE_ERR)
+			nodeErrPoll();
+	}
+
+	//handshake of inactive node (only this node is deleated on failure)
+	uint8_t isActivated = 0;
+	for(e = 0;e < count;e++){
+		uintptr_t data = (uintptr_t)events[e].data.ptr;
+		if((data & EVENT_KIND_MASK) != EVENT_NODE_BEGIN)
+			continue;
+
+		nodeData* node = (nodeData*)(data & ~(uintptr_t)EVENT_KIND_MASK);
+		int ret = nodeBegin(node);
+		if(ret == 0){
+			nodeActivate(node);
+			isActivated = 1;
+		}else if(ret < 0){
+			//kill
+			kill(node->pid,SIGTERM);
+			//deleate from list
+			nodeData** itr;
+			LINEAR_LIST_FOREACH(inactiveNodeList,itr){
+				if(*itr == node){
+					LINEAR_LIST_ERASE(itr);
+					break;
+				}
+			}
+			//deleate node
+			nodeDeleate(node);
+		}else if(events[e].events & (EPOLLHUP | EPOLLERR)){
+			//closed before handshake (SIGCHLD cleans up)
+			epoll_ctl(epollFd,EPOLL_CTL_DEL,node->fd[0],NULL);
+		}
+	}
+	if(isActivated)
+		nodeLevelUpdate();
+
+	//control message and node exit last (they may deleate any node)
+	for(e = 0;e < count;e++){
+		uintptr_t data = (uintptr_t)events[e].data.ptr;
+		if(data == EVENT_CTRL){
+			//message from parent (frames may be buffered already)
+			do{
+				uint8_t head;
+				int res = ctrlReadWithTimeOut(&head,sizeof(head),0);
+				if(res < 0)
+					return -1;
+				if(res != sizeof(head))
+					break;
+
+				//serch table
+				int i;
+				for(i = 0;i < (sizeof(opTable)/sizeof(opTable[0]));i++){
+					if(head == opTable[i].op){
+						opTable[i].func();
+						ctrlFlush();
+						break;
+					}
+				}
+			}while(ctrlInPos != ctrlInLen);
+		}else if(data == EVENT_SIGNAL){
+			//node exit
+			nodeReap();
+		}
+	}
+
+	return 0;
+}
+
+static void nodeReap(){
+	//drain signalfd
+	struct signalfd_siginfo info;
+	while(read(signalFd,&info,sizeof(info)) == sizeof(info));
+
+	//reap every exited child (node, killed node, timer)
+	int dead;
+	int isDeleated = 0;
+	while((dead = waitpid(-1,NULL,WNOHANG)) > 0){
+		nodeData** itr;
+		LINEAR_LIST_FOREACH(activeNodeList,itr){
+			if((*itr)->pid == dead){
+				debugPrintf("%s(): [%s]: node exited",__func__,(*itr)->name);
+				(*itr)->pid = 0;
+				nodeDeleate(*itr);
+				LINEAR_LIST_ERASE(itr);
+				isDeleated = 1;
+				break;
+			}
+		}
+		LINEAR_LIST_FOREACH(inactiveNodeList,itr){
+			if((*itr)->pid == dead){
+				debugPrintf("%s(): [%s]: node exited before handshake",__func__,(*itr)->name);
+				(*itr)->pid = 0;
+				nodeDeleate(*itr);
+				LINEAR_LIST_ERASE(itr);
+				break;
+			}
+		}
+	}
+	if(isDeleated)
+		nodeLevelUpdate();
 }
 
-static void nodeSystemLoop(){
-	//check inactive nodes
+static void nodeErrDrain(nodeData* node){
+	//read all pending output so node never blocks on stderr
+	char buf[4096];
+	ssize_t n;
+	while((n = read(node->fd[2],buf,sizeof(buf))) > 0){
+		if(node->errBuffer == NULL && (node->errBuffer = malloc(logBufferSize)) == NULL){
+			node->errDropped += n;
+			continue;
+		}
+
+		char* src = buf;
+		size_t space = logBufferSize - node->errLen;
+		if((size_t)n > space){
+			if(logDropPolicy == NODE_LOG_DROP_NEWEST){
+				//keep buffered output, drop new one
+				node->errDropped += n - space;
+				n = space;
+			}else{
+				//drop oldest output
+				if((size_t)n > logBufferSize){
+					node->errDropped += n - logBufferSize;
+					src += n - logBufferSize;
+					n = logBufferSize;
+				}
+				size_t drop = n - (logBufferSize - node->errLen);
+				node->errDropped += drop;
+				node->errHead = (node->errHead + drop) % logBufferSize;
+				node->errLen -= drop;
+			}
+		}
+
+		//append with wrap
+		size_t tail = (node->errHead + node->errLen) % logBufferSize;
+		size_t first = logBufferSize - tail < (size_t)n ? logBufferSize - tail : (size_t)n;
+		memcpy(node->errBuffer + tail,src,first);
+		memcpy(node->errBuffer,src + first,n - first);
+		node->errLen += n;
+	}
+
+	//node closed stderr
+	if(n == 0)
+		epoll_ctl(errEpollFd,EPOLL_CTL_DEL,node->fd[2],NULL);
+
+	if(node->errLen >= logBufferSize / 2)
+		nodeErrFlush(node);
+	else if(node->errLen != 0 || node->errDropped != 0)
+		logPending = 1;
+}
+
+static void nodeErrPoll(){
+	//drain stderr of every ready node (no node is deleated meanwhile)
+	struct epoll_event events[NODE_EVENT_MAX];
+	int count;
+	do{
+		count = epoll_wait(errEpollFd,events,NODE_EVENT_MAX,0);
+		int e;
+		for(e = 0;e < count;e++)
+			nodeErrDrain((nodeData*)((uintptr_t)events[e].data.ptr & ~(uintptr_t)EVENT_KIND_MASK));
+	}while(count == NODE_EVENT_MAX);
+}
+
+static void nodeErrFlush(nodeData* node){
+	if(node->errFd >= 0){
+		//note lost output
+		if(node->errDropped != 0)
+			dprintf(node->errFd,"[%s] %" PRIu64 " bytes of stderr dropped\n",getRealTimeStr(),node->errDropped);
+
+		//ring in one writev
+		size_t first = logBufferSize - node->errHead < node->errLen ? logBufferSize - node->errHead : node->errLen;
+		struct iovec iov[2] = {
+			{.iov_base = node->errBuffer + node->errHead,.iov_len = first},
+			{.iov_base = node->errBuffer,.iov_len = node->errLen - first}
+		};
+		if(node->errLen != 0 && writev(node->errFd,iov,2) < 0)
+			debugPrintf("%s(): [%s]: writev(): %s",__func__,node->name,strerror(errno));
+	}
+
+	node->errHead = 0;
+	node->errLen = 0;
+	node->errDropped = 0;
+}
+
+static void nodeErrFlushAll(){
 	nodeData** itr;
+	LINEAR_LIST_FOREACH(activeNodeList,itr){
+		nodeErrFlush(*itr);
+	}
 	LINEAR_LIST_FOREACH(inactiveNodeList,itr){
-		int ret = nodeBegin(*itr);
-		if(ret == 0){
-			nodeData* data = *itr;
-			LINEAR_LIST_ERASE(itr);
-			LINEAR_LIST_PUSH(activeNodeList,data);
+		nodeErrFlush(*itr);
+	}
+	logPending = 0;
+}
 
-			int i;
-			int* pidList = wakeupNodeArray.shmMap;
-			for(i = 1;pidList[i] != 0;i++){
+static int eventAdd(int epoll,int eventFd,nodeData* node,uint8_t kind){
+	//owner is found without list scan
+	struct epoll_event event = {.events = EPOLLIN,.data.ptr = (void*)((uintptr_t)node | kind)};
+	if(epoll_ctl(epoll,EPOLL_CTL_ADD,eventFd,&event) != 0){
+		debugPrintf("%s(): epoll_ctl(): %s",__func__,strerror(errno));
+		return -1;
+	}
+	return 0;
+}
+
+static uint32_t nameHash(const char* name){
+	//FNV-1a
+	uint32_t hash = 2166136261u;
+	while(*name){
+		hash ^= (uint8_t)*name++;
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+static nodeData* nodeFind(const char* name){
+	if(nodeIndexCount == 0)
+		return NULL;
+
+	uint32_t mask = nodeIndexSize - 1;
+	uint32_t i;
+	for(i = nameHash(name) & mask;nodeIndex[i] != NULL;i = (i + 1) & mask){
+		if(strcmp(nodeIndex[i]->name,name) == 0)
+			return nodeIndex[i];
+	}
+	return NULL;
+}
+
+static int nodeIndexAdd(nodeData* node){
+	//keep load factor under 1/2
+	if((nodeIndexCount + 1) * 2 > nodeIndexSize){
+		uint32_t size = nodeIndexSize ? nodeIndexSize * 2 : 64;
+		nodeData** table = calloc(size,sizeof(nodeData*));
+		if(table == NULL){
+			debugPrintf("%s(): calloc(): %s",__func__,strerror(errno));
+			return -1;
+		}
+
+		uint32_t i;
+		for(i = 0;i < nodeIndexSize;i++){
+			if(nodeIndex[i] == NULL)
+				continue;
+			uint32_t j = nameHash(nodeIndex[i]->name) & (size - 1);
+			while(table[j] != NULL)
+				j = (j + 1) & (size - 1);
+			table[j] = nodeIndex[i];
+		}
+		free(nodeIndex);
+		nodeIndex = table;
+		nodeIndexSize = size;
+	}
+
+	uint32_t mask = nodeIndexSize - 1;
+	uint32_t i = nameHash(node->name) & mask;
+	while(nodeIndex[i] != NULL)
+		i = (i + 1) & mask;
+	nodeIndex[i] = node;
+	nodeIndexCount++;
+
+	return 0;
+}
+
+static void nodeIndexRemove(nodeData* node){
+	if(nodeIndexCount == 0)
+		return;
+
+	uint32_t mask = nodeIndexSize - 1;
+	uint32_t i = nameHash(node->name) & mask;
+	while(nodeIndex[i] != node){
+		if(nodeIndex[i] == NULL)
+			return;
+		i = (i + 1) & mask;
+	}
+
+	//shift back following entries of the probe chain
+	uint32_t j = i;
+	while(1){
+		nodeIndex[i] = NULL;
+		while(1){
+			j = (j + 1) & mask;
+			if(nodeIndex[j] == NULL){
+				nodeIndexCount--;
+				return;
 			}
+			uint32_t home = nameHash(nodeIndex[j]->name) & mask;
+			if(((j - home) & mask) >= ((j - i) & mask))
+				break;
+		}
+		nodeIndex[i] = nodeIndex[j];
+		i = j;
+	}
+}
+
+static int pipeIndexBuild(nodeData* node){
+	uint16_t size = 4;
+	while(size < node->pipeCount * 2)
+		size *= 2;
+
+	node->pipeIndex = calloc(size,sizeof(uint16_t));
+	if(node->pipeIndex == NULL){
+		debugPrintf("%s(): calloc(): %s",__func__,strerror(errno));
+		return -1;
+	}
+	node->pipeIndexSize = size;
+
+	//first pipe wins on same name
+	uint16_t p;
+	for(p = 0;p < node->pipeCount;p++){
+		uint16_t i = nameHash(node->pipes[p].pipeName) & (size - 1);
+		while(node->pipeIndex[i] != 0 && strcmp(node->pipes[node->pipeIndex[i] - 1].pipeName,node->pipes[p].pipeName) != 0)
+			i = (i + 1) & (size - 1);
+		if(node->pipeIndex[i] == 0)
+			node->pipeIndex[i] = p + 1;
+	}
+
+	return 0;
+}
+
+static nodePipe* pipeFind(const char* nodeName,const char* pipeName,nodeData** node,uint16_t* index){
+	//pipe of active node
+	nodeData* data = nodeFind(nodeName);
+	if(data == NULL || !data->isActive)
+		return NULL;
+	if(node)
+		*node = data;
+	if(data->pipeIndex == NULL)
+		return NULL;
+
+	uint16_t mask = data->pipeIndexSize - 1;
+	uint16_t i;
+	for(i = nameHash(pipeName) & mask;data->pipeIndex[i] != 0;i = (i + 1) & mask){
+		uint16_t p = data->pipeIndex[i] - 1;
+		if(strcmp(data->pipes[p].pipeName,pipeName) == 0){
+			if(index)
+				*index = p;
+			return &data->pipes[p];
+		}
+	}
+	return NULL;
+}
+
+static NODE_HANDLE handleMake(nodeData* node,int pipe){
+	//generation << 32 | (pipe number + 1) << 16 | wakeup slot (pipe -1: node handle)
+	return ((uint64_t)(handleGen[node->slot] + 1) << 32) | ((uint64_t)(pipe + 1) << 16) | (uint64_t)node->slot;
+}
+
+static nodeData* handleFind(NODE_HANDLE handle,uint16_t* pipe){
+	uint32_t slot = handle & 0xFFFF;
+	uint16_t number = (handle >> 16) & 0xFFFF;
+	uint32_t gen = handle >> 32;
+
+	//slot is released or reused by other node
+	if(slot >= WAKEUP_NODE_MAX || handleNode[slot] == NULL || handleGen[slot] + 1 != gen){
+		debugPrintf("%s(): Handle is stale",__func__);
+		return NULL;
+	}
+
+	nodeData* node = handleNode[slot];
+	if(pipe != NULL){
+		if(number == 0 || number > node->pipeCount){
+			debugPrintf("%s(): Handle is not pipe",__func__);
+			return NULL;
+		}
+		*pipe = number - 1;
+	}
+	return node;
+}
+
+static void timerLoop(int parent){
+	wakeupTable* table = wakeupNodeArray.shmMap;
+	uint32_t* woken = malloc(sizeof(uint32_t)*WAKEUP_NODE_MAX);
+	shareMemoryOpen(&systemSettingKey,SHM_RDONLY);
+
+	//absolute deadline on CLOCK_MONOTONIC
+	struct timespec spec;
+	clock_gettime(CLOCK_MONOTONIC,&spec);
+	uint64_t deadline = spec.tv_sec * 1000000000ULL + spec.tv_nsec;
+	uint64_t lastFire = 0;
+	while(kill(parent,0) == 0){
+		shareMemoryLock(&systemSettingKey);
+		nodeSystemEnv* env = systemSettingKey.shmMap;
+		uint64_t period = env->period * 1000000LL;
+		shareMemoryUnLock(&systemSettingKey);
+		if(period == 0)
+			period = 1;
+
+		//sleep until next deadline (no drift by work of previous tick)
+		deadline += period;
+		spec.tv_sec = deadline / 1000000000ULL;
+		spec.tv_nsec = deadline % 1000000000ULL;
+		while(clock_nanosleep(CLOCK_MONOTONIC,TIMER_ABSTIME,&spec,NULL) == EINTR);
+
+		clock_gettime(CLOCK_MONOTONIC,&spec);
+		uint64_t now = spec.tv_sec * 1000000000ULL + spec.tv_nsec;
+		uint64_t missed = 0;
+		if(now < deadline)
+			now = deadline;
+
+		shareMemoryLock(&wakeupNodeArray);
+		//whole periods passed: skip to latest deadline or fire them back to back
+		if(now - deadline >= period && table->policy == NODE_TIMER_SKIP){
+			missed = (now - deadline) / period;
+			deadline += missed * period;
+		}
+
+		int isRun = table->isRun;
+		uint64_t tick = table->tick;
+		uint32_t levels = table->levels;
+		if(isRun){
+			table->tick++;
+
+			//statistics
+			uint64_t late = now - deadline;
+			table->stat.ticks++;
+			table->stat.missed += missed;
+			table->stat.lateSum += late;
+			if(late > table->stat.lateMax)
+				table->stat.lateMax = late;
+			if(lastFire != 0){
+				uint64_t interval = now - lastFire;
+				uint64_t jitter = interval > period ? interval - period : period - interval;
+				table->stat.jitterSum += jitter;
+				if(jitter > table->stat.jitterMax)
+					table->stat.jitterMax = jitter;
+			}
+			lastFire = now;
+		}else{
+			lastFire = 0;
+		}
+		shareMemoryUnLock(&wakeupNodeArray);
+
+		//wake level by level (next level after previous one is done)
+		uint32_t level;
+		for(level = 0;isRun && level < levels;level++){
+			uint32_t i,n = 0;
 			shareMemoryLock(&wakeupNodeArray);
-			pidList[i] = (*itr)->pid;
+			for(i = 0;i < table->count;i++){
+				wakeupSlot* slot = &table->nodes[i];
+				//harmonic rate groups: node wakes on ticks divisible by its divisor
+				if(slot->pid != 0 && slot->level == level && tick % slot->divisor == 0){
+					//still running previous wake: overrun (it waits for next own tick)
+					uint32_t done = __atomic_load_n(&slot->done,__ATOMIC_ACQUIRE);
+					if(done != 0 && done != slot->wake){
+						slot->overrun++;
+						continue;
+					}
+
+					__atomic_store_n(&slot->deadline,deadline + period * slot->divisor,__ATOMIC_RELAXED);
+					clock_gettime(CLOCK_MONOTONIC,&spec);
+					__atomic_store_n(&slot->wakeTime,spec.tv_sec * 1000000000ULL + spec.tv_nsec,__ATOMIC_RELAXED);
+					__atomic_add_fetch(&slot->wake,1,__ATOMIC_RELEASE);
+					kill(slot->pid,SIGCONT);
+					woken[n++] = i;
+				}
+			}
 			shareMemoryUnLock(&wakeupNodeArray);
-		}else if(ret < 0){
-			//kill
-			kill((*itr)->pid,SIGTERM);
-			//deleate node
-			nodeDeleate(*itr);
-			//deleate from list
-			LINEAR_LIST_ERASE(itr);
-			break;
+
+			//give up waiting at next deadline
+			if(n != 0 && level + 1 < levels)
+				timerWaitDone(table,woken,n,deadline + period);
 		}
 	}
 
-	//check active node
+	free(woken);
+	shareMemoryClose(&systemSettingKey);
+	shareMemoryDeleate(&wakeupNodeArray);
+}
+
+static void timerWaitDone(wakeupTable* table,const uint32_t* slots,uint32_t count,uint64_t limit){
+	while(1){
+		uint32_t seen = __atomic_load_n(&table->doneCount,__ATOMIC_ACQUIRE);
+
+		//node never reported completion is not waited (event driven node)
+		uint32_t i;
+		for(i = 0;i < count;i++){
+			wakeupSlot* slot = &table->nodes[slots[i]];
+			uint32_t done = __atomic_load_n(&slot->done,__ATOMIC_ACQUIRE);
+			if(done != 0 && done != __atomic_load_n(&slot->wake,__ATOMIC_RELAXED))
+				break;
+		}
+		if(i == count)
+			return;
+
+		struct timespec spec;
+		clock_gettime(CLOCK_MONOTONIC,&spec);
+		uint64_t now = spec.tv_sec * 1000000000ULL + spec.tv_nsec;
+		if(now >= limit)
+			return;
+		spec.tv_sec = (limit - now) / 1000000000ULL;
+		spec.tv_nsec = (limit - now) % 1000000000ULL;
+
+		//sleep until a node reports
+		__atomic_store_n(&table->waiting,1,__ATOMIC_SEQ_CST);
+		syscall(SYS_futex,&table->doneCount,FUTEX_WAIT,seen,&spec,NULL,0);
+		__atomic_store_n(&table->waiting,0,__ATOMIC_RELAXED);
+	}
+}
+
+static void nodeLevelUpdate(){
+	//count active node and source edge
+	int count = 0,edgeCount = 0;
+	int i,j,k;
+	nodeData** itr;
 	LINEAR_LIST_FOREACH(activeNodeList,itr){
-		//check process
-		if(kill((*itr)->pid,0)){
-			//deleate node
-			nodeDeleate(*itr);
-			//deleate from list
-			LINEAR_LIST_ERASE(itr);
+		count++;
+		for(j = 0;j < (*itr)->pipeCount;j++){
+			nodePipe* pipe = &(*itr)->pipes[j];
+			if(pipe->option & NODE_PIPE_OPT_DELAY)
+				continue;
+			if(pipe->type == NODE_PIPE_MERGE)
+				edgeCount += pipe->mergeCount;
+			else if(pipe->type == NODE_PIPE_IN && pipe->connectNode != NULL)
+				edgeCount++;
+		}
+	}
+
+	nodeData** nodes = malloc(sizeof(nodeData*)*(count + 1));
+	int* level = malloc(sizeof(int)*(count + 1));
+	int* degree = malloc(sizeof(int)*(count + 1));		//unresolved source count
+	int* queue = malloc(sizeof(int)*(count + 1));
+	int* edgeHead = malloc(sizeof(int)*(count + 1));	//first edge from the node
+	int* edgeNext = malloc(sizeof(int)*(edgeCount + 1));
+	int* edgeTo = malloc(sizeof(int)*(edgeCount + 1));
+	if(!nodes || !level || !degree || !queue || !edgeHead || !edgeNext || !edgeTo){
+		debugPrintf("%s(): malloc failed: keep previous level",__func__);
+		free(nodes);
+		free(level);
+		free(degree);
+		free(queue);
+		free(edgeHead);
+		free(edgeNext);
+		free(edgeTo);
+		return;
+	}
+
+	int n = 0;
+	LINEAR_LIST_FOREACH(activeNodeList,itr){
+		nodes[n] = *itr;
+		nodes[n]->order = n;
+		level[n] = 0;
+		degree[n] = 0;
+		edgeHead[n] = -1;
+		n++;
+	}
+
+	//adjacency from source to reader (delay edge is ignored)
+	int e = 0;
+	for(i = 0;i < count;i++){
+		for(j = 0;j < nodes[i]->pipeCount;j++){
+			nodePipe* pipe = &nodes[i]->pipes[j];
+			if(pipe->option & NODE_PIPE_OPT_DELAY)
+				continue;
+
+			//source node names of this pipe
+			char** src = pipe->type == NODE_PIPE_MERGE ? pipe->mergeNode : &pipe->connectNode;
+			int srcCount = pipe->type == NODE_PIPE_MERGE ? pipe->mergeCount : (pipe->type == NODE_PIPE_IN && pipe->connectNode != NULL);
+			for(k = 0;k < srcCount;k++){
+				nodeData* source = nodeFind(src[k]);
+				if(source == NULL || !source->isActive)
+					continue;
+				int m = source->order;
+				if(m == i || m < 0 || m >= count || nodes[m] != source)
+					continue;
+				edgeTo[e] = i;
+				edgeNext[e] = edgeHead[m];
+				edgeHead[m] = e;
+				degree[i]++;
+				e++;
+			}
 		}
 	}
 
-	//message from parent 
-	uint8_t head;
-	if(fileReadWithTimeOut(fd[0],&head,sizeof(head),1) == sizeof(head)){
-		//serch table
+	//node level is one more than its deepest source
+	int front = 0,back = 0,maxLevel = -1;
+	for(i = 0;i < count;i++){
+		if(degree[i] == 0)
+			queue[back++] = i;
+	}
+	while(front < back){
+		i = queue[front++];
+		if(level[i] > maxLevel)
+			maxLevel = level[i];
+		for(e = edgeHead[i];e >= 0;e = edgeNext[e]){
+			j = edgeTo[e];
+			if(level[i] + 1 > level[j])
+				level[j] = level[i] + 1;
+			if(--degree[j] == 0)
+				queue[back++] = j;
+		}
+	}
+
+	//cycle without delay edge: wake the rest together after others
+	if(back < count){
+		for(i = 0;i < count;i++){
+			if(degree[i] > 0){
+				debugPrintf("%s(): [%s]: pipe cycle without delay edge",__func__,nodes[i]->name);
+				level[i] = maxLevel + 1;
+			}
+		}
+		maxLevel++;
+	}
+
+	//write to wakeup table
+	wakeupTable* table = wakeupNodeArray.shmMap;
+	shareMemoryLock(&wakeupNodeArray);
+	for(i = 0;i < count;i++){
+		if(nodes[i]->slot >= 0)
+			table->nodes[nodes[i]->slot].level = level[i];
+	}
+	table->levels = maxLevel >= 0 ? maxLevel + 1 : 1;
+	shareMemoryUnLock(&wakeupNodeArray);
+
+	free(nodes);
+	free(level);
+	free(degree);
+	free(queue);
+	free(edgeHead);
+	free(edgeNext);
+	free(edgeTo);
+}
+
+static int schedApply(int pid,const char* name,const char* cpuList,uint8_t policy,int priority,double runtime,double period){
+	int res = 0;
+
+	//cpu list like "0,2-3"
+	if(cpuList && cpuList[0]){
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		const char* p = cpuList;
+		while(*p){
+			char* end;
+			long first = strtol(p,&end,10);
+			long last = first;
+			if(end == p)
+				break;
+			if(*end == '-')
+				last = strtol(end + 1,&end,10);
+			for(;first <= last && first < CPU_SETSIZE;first++)
+				CPU_SET(first,&set);
+			p = (*end == ',') ? end + 1 : end;
+		}
+
+		if(CPU_COUNT(&set) == 0){
+			debugPrintf("%s(): [%s]: empty cpu list \"%s\": keep default affinity",__func__,name,cpuList);
+			res = -1;
+		}else if(sched_setaffinity(pid,sizeof(set),&set) != 0){
+			debugPrintf("%s(): [%s]: sched_setaffinity(%s): %s: keep default affinity",__func__,name,cpuList,strerror(errno));
+			res = -1;
+		}
+	}
+
+	if(policy == NODE_SCHED_DEADLINE){
+		//runtime defaults to half of period
+		schedAttr attr = {};
+		attr.size = sizeof(attr);
+		attr.policy = SCHED_DEADLINE;
+		attr.runtime = (runtime > 0 ? runtime : period / 2) * 1000000LL;
+		attr.deadline = period * 1000000LL;
+		attr.period = period * 1000000LL;
+		if(syscall(SYS_sched_setattr,pid,&attr,0) != 0){
+			debugPrintf("%s(): [%s]: sched_setattr(): %s: fall back to SCHED_OTHER",__func__,name,strerror(errno));
+			res = -1;
+		}
+	}else if(policy == NODE_SCHED_FIFO || policy == NODE_SCHED_RR){
+		//clamp to valid range of policy (0 is never valid for real-time)
+		int sched = policy == NODE_SCHED_FIFO ? SCHED_FIFO : SCHED_RR;
+		int min = sched_get_priority_min(sched);
+		int max = sched_get_priority_max(sched);
+		if(priority < min || priority > max){
+			int clamped = priority < min ? min : max;
+			debugPrintf("%s(): [%s]: priority %d is out of %d-%d: use %d",__func__,name,priority,min,max,clamped);
+			priority = clamped;
+		}
+
+		struct sched_param param = {.sched_priority = priority};
+		if(sched_setscheduler(pid,sched,&param) != 0){
+			debugPrintf("%s(): [%s]: sched_setscheduler(): %s: fall back to SCHED_OTHER",__func__,name,strerror(errno));
+			res = -1;
+		}
+	}
+
+	return res;
+}
+
+static int popenRWasNonBlock(const char* command,char* const* argv,char* const* envp,int* fd){
+
+	int pipeTx[2] = {-1,-1};
+	int pipeRx[2] = {-1,-1};
+	int pipeErr[2] = {-1,-1};
+	//create pipe (close on exec keeps pipes of other nodes out of child)
+	if(pipe2(pipeTx,O_CLOEXEC) < 0 || pipe2(pipeRx,O_CLOEXEC) < 0 || pipe2(pipeErr,O_CLOEXEC) < 0){
+		debugPrintf("%s(): pipe2(): %s",__func__,strerror(errno));
 		int i;
-		for(i = 0;i < (sizeof(opTable)/sizeof(opTable[0]));i++){
-			if(head == opTable[i].op){
-				opTable[i].func();
+		for(i = 0;i < 2;i++){
+			if(pipeTx[i] >= 0)
+				close(pipeTx[i]);
+			if(pipeRx[i] >= 0)
+				close(pipeRx[i]);
+			if(pipeErr[i] >= 0)
+				close(pipeErr[i]);
+		}
+		return -1;
+	}
+
+	//child stdio (dup2 clears close on exec)
+	posix_spawn_file_actions_t actions;
+	posix_spawn_file_actions_init(&actions);
+	posix_spawn_file_actions_adddup2(&actions,pipeTx[0],STDIN_FILENO);
+	posix_spawn_file_actions_adddup2(&actions,pipeRx[1],STDOUT_FILENO);
+	posix_spawn_file_actions_adddup2(&actions,pipeErr[1],STDERR_FILENO);
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 34)
+	//control pipe, epoll and log of manager are not for node
+	posix_spawn_file_actions_addclosefrom_np(&actions,STDERR_FILENO + 1);
+#endif
+
+	//manager blocks SIGCHLD for signalfd
+	posix_spawnattr_t attr;
+	posix_spawnattr_init(&attr);
+	sigset_t mask;
+	sigemptyset(&mask);
+	posix_spawnattr_setsigmask(&attr,&mask);
+	posix_spawnattr_setflags(&attr,POSIX_SPAWN_SETSIGMASK);
+
+	//no copy of manager memory (vfork like), exec error is returned here
+	pid_t process;
+	int err = posix_spawn(&process,command,&actions,&attr,argv,envp);
+	posix_spawn_file_actions_destroy(&actions);
+	posix_spawnattr_destroy(&attr);
+
+	//close pipe
+	close(pipeTx[0]);
+	close(pipeRx[1]);
+	close(pipeErr[1]);
+	if(err != 0){
+		debugPrintf("%s(): posix_spawn(): %s: %s",__func__,command,strerror(err));
+		close(pipeTx[1]);
+		close(pipeRx[0]);
+		close(pipeErr[0]);
+		return -1;
+	}
+	fd[0] = pipeRx[0];
+	fd[1] = pipeTx[1];
+	fd[2] = pipeErr[0];
+
+	//set nonblock
+	fcntl(fd[0],F_SETFL,fcntl(fd[0],F_GETFL) | O_NONBLOCK);
+	fcntl(fd[1],F_SETFL,fcntl(fd[1],F_GETFL) | O_NONBLOCK);
+	fcntl(fd[2],F_SETFL,fcntl(fd[2],F_GETFL) | O_NONBLOCK);
+
+	return process;
+}
+
+static char** nodeEnvBuild(nodeData* node){
+	//manager environment overridden by "-env" of node
+	size_t count = 0;
+	while(environ[count] != NULL)
+		count++;
+
+	char** envp = malloc(sizeof(char*) * (count + node->envCount + 1));
+	if(envp == NULL)
+		return NULL;
+
+	size_t n = 0,i;
+	for(i = 0;i < count;i++){
+		size_t len = strcspn(environ[i],"=");
+		int j;
+		for(j = 0;j < node->envCount;j++){
+			if(strncmp(node->env[j],environ[i],len + 1) == 0)
 				break;
+		}
+		if(j == node->envCount)
+			envp[n++] = environ[i];
+	}
+	for(i = 0;i < node->envCount;i++)
+		envp[n++] = node->env[i];
+	envp[n] = NULL;
+
+	return envp;
+}
+
+static void optionWrite(FILE* file,uint8_t* isFirst,const char* name,const char* value){
+	fprintf(file,*isFirst ? "%s " : " %s ",name);
+	*isFirst = 0;
+
+	//plain value
+	if(value[0] != '\0' && strpbrk(value," \t\n\"\\") == NULL){
+		fputs(value,file);
+		return;
+	}
+
+	//quoted value (\\, \" and \n are escaped)
+	fputc('"',file);
+	for(;*value;value++){
+		if(*value == '\n'){
+			fputs("\\n",file);
+			continue;
+		}
+		if(*value == '"' || *value == '\\')
+			fputc('\\',file);
+		fputc(*value,file);
+	}
+	fputc('"',file);
+}
+
+static char* optionToken(char** cursor){
+	//skip separator
+	char* p = *cursor;
+	while(*p == ' ' || *p == '\t' || *p == '\n')
+		p++;
+	if(*p == '\0'){
+		*cursor = p;
+		return NULL;
+	}
+
+	//unquote in place
+	char* token = p;
+	char* out = p;
+	char* next;
+	if(*p == '"'){
+		p++;
+		while(*p != '\0' && *p != '"'){
+			if(*p == '\\' && p[1] != '\0'){
+				p++;
+				*out++ = (*p == 'n') ? '\n' : *p;
+				p++;
+			}else{
+				*out++ = *p++;
 			}
 		}
+		if(*p == '"')
+			p++;
+		next = p;
 	}else{
-		//timer
-		static const struct timespec req = {.tv_sec = 0,.tv_nsec = 1000*1000};
-		nanosleep(&req,NULL);
+		while(*p != '\0' && *p != ' ' && *p != '\t' && *p != '\n')
+			*out++ = *p++;
+		next = (*p != '\0') ? p + 1 : p;
 	}
+	*out = '\0';
+
+	*cursor = next;
+	return token;
 }
 
-static int popenRWasNonBlock(const char const * command,int* fd){
+static int arenaGenerate(size_t size,shm_key* shm){
+	//cache line aligned block with semaphore prefix
+	size_t blockSize = (size + SHM_PREFIX_SIZE + 63) & ~(size_t)63;
 
-	int pipeTx[2];
-	int pipeRx[2];
-	int pipeErr[2];
-	//create pipe
-	if(pipe(pipeTx) < 0 || pipe(pipeRx) < 0 || pipe(pipeErr) < 0){
-		debugPrintf("%s(): pipe(): %s",__func__,strerror(errno));
+	//first fit
+	int i;
+	for(i = 0;i < arenaFreeCount;i++){
+		if(arenaFreeList[i].size >= blockSize)
+			break;
+	}
+
+	//arena is disabled or full
+	if(i == arenaFreeCount){
+		if(pipeArena.size)
+			debugPrintf("%s(): pipe arena is full",__func__);
+		return shareMemoryGenerate(size,shm);
+	}
+
+	//carve block
+	memset(shm,0,sizeof(*shm));
+	shm->backend = SHM_ARENA;
+	shm->offset = arenaFreeList[i].offset;
+	shm->size = blockSize;
+	arenaFreeList[i].offset += blockSize;
+	arenaFreeList[i].size -= blockSize;
+	if(arenaFreeList[i].size == 0){
+		memmove(&arenaFreeList[i],&arenaFreeList[i+1],sizeof(arenaBlock)*(arenaFreeCount-i-1));
+		arenaFreeCount--;
+	}
+
+	//init semaphore and clear memory
+	void* block = pipeArena.shmMap + shm->offset;
+	memset(block,0,blockSize);
+	if(sem_init(block,1,1) != 0){
+		debugPrintf("%s(): sem_init(): %s",__func__,strerror(errno));
+		arenaDeleate(shm);
 		return -1;
 	}
 
-	//fork
-	int process = fork();
-	if(process == -1){
-		debugPrintf("%s(): fork(): %s",__func__,strerror(errno));
+	return 0;
+}
+
+static int arenaDeleate(shm_key* shm){
+	//memory is not carved out of arena
+	if(shm->backend != SHM_ARENA)
+		return shareMemoryDeleate(shm);
+
+	if(shm->shmMap)
+		shareMemoryClose(shm);
+
+	//insert block to sorted free list
+	int i;
+	for(i = 0;i < arenaFreeCount;i++){
+		if(arenaFreeList[i].offset > shm->offset)
+			break;
+	}
+	arenaFreeList = realloc(arenaFreeList,sizeof(arenaBlock)*(arenaFreeCount+1));
+	memmove(&arenaFreeList[i+1],&arenaFreeList[i],sizeof(arenaBlock)*(arenaFreeCount-i));
+	arenaFreeList[i].offset = shm->offset;
+	arenaFreeList[i].size = shm->size;
+	arenaFreeCount++;
+
+	//merge with next block
+	if(i+1 < arenaFreeCount && arenaFreeList[i].offset + arenaFreeList[i].size == arenaFreeList[i+1].offset){
+		arenaFreeList[i].size += arenaFreeList[i+1].size;
+		memmove(&arenaFreeList[i+1],&arenaFreeList[i+2],sizeof(arenaBlock)*(arenaFreeCount-i-2));
+		arenaFreeCount--;
+	}
+
+	//merge with previous block
+	if(i > 0 && arenaFreeList[i-1].offset + arenaFreeList[i-1].size == arenaFreeList[i].offset){
+		arenaFreeList[i-1].size += arenaFreeList[i].size;
+		memmove(&arenaFreeList[i],&arenaFreeList[i+1],sizeof(arenaBlock)*(arenaFreeCount-i-1));
+		arenaFreeCount--;
+	}
+
+	shm->size = 0;
+	return 0;
+}
+
+static int pipeMemoryInit(shm_key* shm,uint8_t mode,uint16_t depth){
+	//check argment
+	if(!shm){
+		debugPrintf("%s(): invalid argment",__func__);
 		return -1;
 	}
 
- 	if(process == 0)
-	{//child
-	 	//dup pipe
-		close(pipeTx[1]);
-		close(pipeRx[0]);
-		close(pipeErr[0]);
-		dup2(pipeTx[0], STDIN_FILENO);
-		dup2(pipeRx[1], STDOUT_FILENO);
-		dup2(pipeErr[1], STDERR_FILENO);
-		close(pipeTx[0]);
-		close(pipeRx[1]);
-		close(pipeErr[1]);
-		
-		execl(command,command,NULL);
+	//attach
+	if(shareMemoryOpen(shm,0) != 0)
+		return -1;
 
-		exit(EXIT_SUCCESS);
+	//init header
+	pipeHead* head = shm->shmMap;
+	memset(head,0,PIPE_HEAD_SIZE);
+	head->version = PIPE_HEAD_VERSION;
+	head->mode = mode;
+	head->depth = depth;
+
+	//triple buffer: 0 is latest, 1 is written next
+	head->latest = 0;
+	head->back = 1;
+
+	return shareMemoryClose(shm);
+}
+
+static int shareMemorySendKey(int fd,shm_key* shm){
+	uint64_t size = shm->size;
+	fileWrite(fd,&shm->backend,sizeof(shm->backend));
+	fileWrite(fd,&shm->semId,sizeof(shm->semId));
+	fileWrite(fd,&shm->shmId,sizeof(shm->shmId));
+	fileWrite(fd,&shm->ownerPid,sizeof(shm->ownerPid));
+	fileWrite(fd,&shm->memFd,sizeof(shm->memFd));
+	fileWrite(fd,&shm->offset,sizeof(shm->offset));
+	return fileWrite(fd,&size,sizeof(size));
+}
+
+static void nodeEventNotify(){
+	//bump event word and wake nodes waiting for inputs
+	nodeSystemEnv* env = systemSettingKey.shmMap;
+	systemSettingMemory->event = __atomic_add_fetch(&env->event,1,__ATOMIC_RELEASE);
+	if(syscall(SYS_futex,&env->event,FUTEX_WAKE,INT_MAX,NULL,NULL,0) < 0)
+		debugPrintf("%s(): futex(): %s",__func__,strerror(errno));
+}
+
+static int ctrlWrite(const void* buf,size_t size){
+	//append to pending frame
+	if(ctrlOutSize == 0)
+		ctrlOutSize = CTRL_FRAME_HEAD;
+	if(ctrlOutSize + size > ctrlOutCap){
+		size_t cap = (ctrlOutSize + size) * 2;
+		uint8_t* out = realloc(ctrlOut,cap < 4096 ? 4096 : cap);
+		if(out == NULL){
+			debugPrintf("%s(): realloc(): %s",__func__,strerror(errno));
+			return -1;
+		}
+		ctrlOut = out;
+		ctrlOutCap = cap < 4096 ? 4096 : cap;
+	}
+	memcpy(ctrlOut + ctrlOutSize,buf,size);
+	ctrlOutSize += size;
+
+	return size;
+}
+
+static int ctrlWriteStr(const char* str){
+	return ctrlWrite(str,strlen(str)+1);
+}
+
+static int ctrlFlush(){
+	if(ctrlOutSize <= CTRL_FRAME_HEAD){
+		ctrlOutSize = 0;
+		return 0;
+	}
+
+	//length prefix and payload in one write
+	uint32_t len = ctrlOutSize - CTRL_FRAME_HEAD;
+	memcpy(ctrlOut,&len,sizeof(len));
+	int res = fileWrite(fd[1],ctrlOut,ctrlOutSize);
+	ctrlOutSize = 0;
+
+	return res < 0 ? -1 : 0;
+}
+
+static uint8_t batchEnter(){
+	//queue following request into batch when batch is open
+	if(!isBatch)
+		return 0;
+	batchSwap();
+	batchCount++;
+	return 1;
+}
+
+static int batchLeave(){
+	batchSwap();
+	return 0;
+}
+
+static void batchSwap(){
+	//exchange pending frame and batch queue
+	uint8_t* buf = ctrlOut;
+	ctrlOut = batchOut;
+	batchOut = buf;
+
+	size_t size = ctrlOutSize;
+	ctrlOutSize = batchOutSize;
+	batchOutSize = size;
+
+	size_t cap = ctrlOutCap;
+	ctrlOutCap = batchOutCap;
+	batchOutCap = cap;
+}
+
+static int ctrlRead(void* buf,size_t size){
+	return ctrlReceive(buf,size,0,-1);
+}
+
+static int ctrlReadStr(char* str,size_t size){
+	return ctrlReceive(str,size,1,-1);
+}
+
+static int ctrlReadWithTimeOut(void* buf,size_t size,uint32_t usec){
+	return ctrlReceive(buf,size,0,usec);
+}
+
+static void ctrlSkip(size_t size){
+	//discard payload that can not be parsed or held
+	uint8_t tmp[256];
+	while(size != 0){
+		int n = ctrlRead(tmp,size < sizeof(tmp) ? size : sizeof(tmp));
+		if(n <= 0)
+			break;
+		size -= n;
+	}
+}
+
+static int ctrlReceive(void* buf,size_t size,uint8_t isStr,int64_t usec){
+	//peer may wait for our pending request
+	if(ctrlFlush() != 0)
+		return -1;
+
+	struct timespec limit;
+	clock_gettime(CLOCK_MONOTONIC,&limit);
+	if(usec >= 0){
+		limit.tv_nsec += 1000LL * usec;
+		limit.tv_sec += limit.tv_nsec / 1000000000LL;
+		limit.tv_nsec %= 1000000000LL;
+	}
+
+	size_t readSize = 0;
+	while(readSize != size){
+		size_t rest = ctrlInLen - ctrlInPos;
+
+		//next frame head
+		if(ctrlInFrame == 0 && rest >= CTRL_FRAME_HEAD){
+			memcpy(&ctrlInFrame,ctrlIn + ctrlInPos,CTRL_FRAME_HEAD);
+			ctrlInPos += CTRL_FRAME_HEAD;
+			continue;
+		}
+
+		//copy from buffered payload
+		if(ctrlInFrame != 0 && rest != 0){
+			size_t n = size - readSize;
+			if(n > rest)
+				n = rest;
+			if(n > ctrlInFrame)
+				n = ctrlInFrame;
+
+			//string ends at '\0'
+			uint8_t* end = isStr ? memchr(ctrlIn + ctrlInPos,'\0',n) : NULL;
+			if(end)
+				n = end - (ctrlIn + ctrlInPos) + 1;
+
+			memcpy(buf + readSize,ctrlIn + ctrlInPos,n);
+			ctrlInPos += n;
+			ctrlInFrame -= n;
+			readSize += n;
+			if(end)
+				break;
+			continue;
+		}
+
+		//refill buffer as much as pipe holds
+		if(ctrlInPos != 0){
+			memmove(ctrlIn,ctrlIn + ctrlInPos,rest);
+			ctrlInPos = 0;
+			ctrlInLen = rest;
+		}
+		ssize_t res = read(fd[0],ctrlIn + ctrlInLen,sizeof(ctrlIn) - ctrlInLen);
+		if(res > 0){
+			ctrlInLen += res;
+		}else if(res == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)){
+			return -1;
+		}else{
+			int ready = fileWait(fd[0],POLLIN,usec >= 0 ? &limit : NULL);
+			if(ready < 0)
+				return -1;
+			if(ready == 0)
+				break;
+		}
 	}
-	else
-	{//parent
-		//close pipe
-		close(pipeTx[0]);
-		close(pipeRx[1]);
-		close(pipeErr[1]);
-		fd[0] = pipeRx[0];
-		fd[1] = pipeTx[1];
-		fd[2] = pipeErr[0];
 
-		//set nonblock
-		fcntl(fd[0],F_SETFL,fcntl(fd[0],F_GETFL) | O_NONBLOCK);
-		fcntl(fd[1],F_SETFL,fcntl(fd[1],F_GETFL) | O_NONBLOCK);
-		fcntl(fd[2],F_SETFL,fcntl(fd[2],F_GETFL) | O_NONBLOCK);
+	return readSize;
+}
 
-		return process;
+static uint64_t histPercentile(const uint32_t* hist,double rate,uint64_t max){
+	uint64_t total = 0;
+	int i;
+	for(i = 0;i < HIST_BUCKETS;i++)
+		total += hist[i];
+	if(total == 0)
+		return 0;
+
+	//upper edge of bucket holding the rank (never above recorded max)
+	uint64_t rank = (uint64_t)(total * rate + 0.999999),sum = 0;
+	for(i = 0;i < HIST_BUCKETS - 1;i++){
+		sum += hist[i];
+		if(sum >= rank)
+			break;
+	}
+	uint64_t value = i;
+	if(i >= (1 << HIST_SUB_BITS)){
+		int exp = (i >> HIST_SUB_BITS) + HIST_SUB_BITS - 1;
+		uint64_t sub = i & ((1 << HIST_SUB_BITS) - 1);
+		value = (((1ULL << HIST_SUB_BITS) + sub + 1) << (exp - HIST_SUB_BITS)) - 1;
 	}
+	return value < max ? value : max;
 }
 
 static int nodeBegin(nodeData* node){
@@ -959,21 +2885,60 @@ static int nodeBegin(nodeData* node){
 		return -1;
 	}
 
+	//reserve wakeup slot
+	wakeupTable* table = wakeupNodeArray.shmMap;
+	shareMemoryLock(&wakeupNodeArray);
+	for(node->slot = 0;node->slot < WAKEUP_NODE_MAX && table->nodes[node->slot].divisor != 0;node->slot++){
+	}
+	if(node->slot < WAKEUP_NODE_MAX){
+		table->nodes[node->slot].divisor = node->divisor;
+		if(table->count <= node->slot)
+			table->count = node->slot + 1;
+	}
+	shareMemoryUnLock(&wakeupNodeArray);
+	if(node->slot == WAKEUP_NODE_MAX){
+		node->slot = -1;
+		debugPrintf("%s(): [%s]: wakeup table is full",__func__,node->name);
+		return -1;
+	}
+
+	//give wakeup table and own slot
+	int32_t slot = node->slot;
+	shareMemorySendKey(node->fd[1],&wakeupNodeArray);
+	fileWrite(node->fd[1],&slot,sizeof(slot));
+
 	//give pipe
 	int i;
 	for(i = 0;i < node->pipeCount;i++){
 		if(node->pipes[i].type != NODE_PIPE_IN){
-			size_t memSize = NODE_DATA_UNIT_SIZE[node->pipes[i].unit] * node->pipes[i].length + 1;
+			size_t memSize = NODE_DATA_UNIT_SIZE[node->pipes[i].unit] * node->pipes[i].length + PIPE_HEAD_SIZE;
+			if(node->pipes[i].type == NODE_PIPE_STREAM)
+				memSize = PIPE_SLOT_SIZE(NODE_DATA_UNIT_SIZE[node->pipes[i].unit] * node->pipes[i].length) * node->pipes[i].depth + PIPE_HEAD_SIZE;
+			else if(node->pipes[i].option & NODE_PIPE_OPT_TRIPLE)
+				memSize = PIPE_SLOT_SIZE(NODE_DATA_UNIT_SIZE[node->pipes[i].unit] * node->pipes[i].length) * 3 + PIPE_HEAD_SIZE;
 
 			//get share memory
-			if(shareMemoryGenerate(memSize,&node->pipes[i].shm) < 0){
+			if(arenaGenerate(memSize,&node->pipes[i].shm) < 0){
 				debugPrintf("%s(): [%s.%s]: failed generate share memory",__func__,node->name,node->pipes[i].pipeName);
 				return -1;
 			}
 
+			//init pipe header
+			uint8_t mode = (node->pipes[i].option & NODE_PIPE_OPT_SEMAPHORE) ? PIPE_MODE_SEMAPHORE : PIPE_MODE_SEQLOCK;
+			uint16_t depth = node->pipes[i].depth;
+			if(node->pipes[i].type == NODE_PIPE_STREAM){
+				mode = PIPE_MODE_STREAM;
+			}else if(node->pipes[i].option & NODE_PIPE_OPT_TRIPLE){
+				mode = PIPE_MODE_TRIPLE;
+				depth = 3;
+			}
+			if(pipeMemoryInit(&node->pipes[i].shm,mode,depth) != 0){
+				debugPrintf("%s(): [%s.%s]: failed init share memory",__func__,node->name,node->pipes[i].pipeName);
+				return -1;
+			}
+
 			
-			fileWrite(node->fd[1],&node->pipes[i].shm.semId,sizeof(node->pipes[i].shm.semId));
-			fileWrite(node->fd[1],&node->pipes[i].shm.shmId,sizeof(node->pipes[i].shm.shmId));
+			shareMemorySendKey(node->fd[1],&node->pipes[i].shm);
 		}
 	}
 
@@ -992,40 +2957,110 @@ static int nodeBegin(nodeData* node){
 }
 
 static void nodeDeleate(nodeData* node){
+	//leave name index and invalidate handles
+	nodeIndexRemove(node);
+	free(node->pipeIndex);
+	if(node->isActive && node->slot >= 0){
+		handleNode[node->slot] = NULL;
+		handleGen[node->slot]++;
+	}
+
 	//releace mem
 	int i;
 	for(i = 0;i < node->pipeCount;i++){
 		//free
 		free(node->pipes[i].pipeName);
+		free(node->pipes[i].mergeNode);
+		free(node->pipes[i].mergePipe);
 
 		//check type
 		if(node->pipes[i].type != NODE_PIPE_IN){
 			//deleate
-			if(shareMemoryDeleate(&node->pipes[i].shm) != 0){
+			if(arenaDeleate(&node->pipes[i].shm) != 0){
 				debugPrintf("%s(): failed deleate memory.",__func__);
 			}
 		}
 	}
 
-	//remove from wakeup List
-	int  f;
-	int* pidList = wakeupNodeArray.shmMap;
-	for(i = 1,f = 0;pidList[i] != 0;i++){
-		if(f){
-			pidList[i - 1] = pidList[i];
-			pidList[i] = 0;
-		}else{
-			if(pidList[i] == node->pid){
-				pidList[i] = 0;
-				f = 1;
+	//disconnect readers of this node (names are owned by it)
+	nodeData** itr;
+	shm_key empty = {};
+	LINEAR_LIST_FOREACH(activeNodeList,itr){
+		if(*itr == node)
+			continue;
+
+		uint16_t p;
+		for(p = 0;p < (*itr)->pipeCount;p++){
+			nodePipe* pipe = &(*itr)->pipes[p];
+			if(pipe->connectNode == node->name){
+				pipe->connectNode = NULL;
+				pipe->connectPipe = NULL;
+				fileWrite((*itr)->fd[1],&p,sizeof(p));
+				shareMemorySendKey((*itr)->fd[1],&empty);
+				nodeEventNotify();
+			}
+
+			int j,k;
+			for(j = 0,k = 0;j < pipe->mergeCount;j++){
+				if(pipe->mergeNode[j] != node->name){
+					pipe->mergeNode[k] = pipe->mergeNode[j];
+					pipe->mergePipe[k] = pipe->mergePipe[j];
+					k++;
+				}
+			}
+			if(k == pipe->mergeCount)
+				continue;
+
+			//remove all source and give remaining ones again
+			pipe->mergeCount = k;
+			fileWrite((*itr)->fd[1],&p,sizeof(p));
+			shareMemorySendKey((*itr)->fd[1],&empty);
+			for(j = 0;j < pipe->mergeCount;j++){
+				nodeData** src;
+				LINEAR_LIST_FOREACH(activeNodeList,src){
+					if((*src)->name != pipe->mergeNode[j])
+						continue;
+					for(k = 0;k < (*src)->pipeCount;k++){
+						if((*src)->pipes[k].pipeName == pipe->mergePipe[j]){
+							fileWrite((*itr)->fd[1],&p,sizeof(p));
+							shareMemorySendKey((*itr)->fd[1],&(*src)->pipes[k].shm);
+						}
+					}
+				}
 			}
+			nodeEventNotify();
 		}
 	}
+
+	//release wakeup slot
+	if(node->slot >= 0){
+		shareMemoryLock(&wakeupNodeArray);
+		memset(&((wakeupTable*)wakeupNodeArray.shmMap)->nodes[node->slot],0,sizeof(wakeupSlot));
+		shareMemoryUnLock(&wakeupNodeArray);
+	}
 	
-	kill(node->pid,SIGINT);
+	//already reaped when pid is 0
+	if(node->pid > 0)
+		kill(node->pid,SIGINT);
+
+	//last stderr output
+	nodeErrDrain(node);
+	nodeErrFlush(node);
+	if(node->errFd >= 0)
+		close(node->errFd);
+	free(node->errBuffer);
+
+	//close node pipe (also leaves epoll set)
+	close(node->fd[0]);
+	close(node->fd[1]);
+	close(node->fd[2]);
 
 	//free
 	free(node->pipes);
+	free(node->cpuList);
+	for(i = 0;i < node->envCount;i++)
+		free(node->env[i]);
+	free(node->env);
 	if((node->name < node->filePath) || (node->name > (node->filePath+strlen(node->filePath))))
 		free(node->name); 
 	free(node->filePath); 
@@ -1034,6 +3069,12 @@ static void nodeDeleate(nodeData* node){
 }
 
 static int receiveNodeProperties(nodeData* node){
+	if(receiveNodeHead(node) != 0)
+		return -1;
+	return receiveNodePipes(node);
+}
+
+static int receiveNodeHead(nodeData* node){
 	char recvBuffer[1024];
 	
 	//receive header
@@ -1044,14 +3085,23 @@ static int receiveNodeProperties(nodeData* node){
 	}
 
 	//read system Env
-	fileWrite(node->fd[1],&systemSettingKey.semId,sizeof(int));
-	fileWrite(node->fd[1],&systemSettingKey.shmId,sizeof(int));
+	shareMemorySendKey(node->fd[1],&systemSettingKey);
+
+	//send pipe arena
+	shareMemorySendKey(node->fd[1],&pipeArena);
 
 	//send path
 	char path[PATH_MAX];
 	sprintf(path,"%s/%s.txt",logFolder,node->name);
 	fileWriteStr(node->fd[1],path);
 
+	return 0;
+}
+
+static int receiveNodePipes(nodeData* node){
+	char recvBuffer[1024];
+	int res;
+
 	//receive pipe count
 	if(fileReadWithTimeOut(node->fd[0],recvBuffer,sizeof(uint16_t),1000000LL) != sizeof(uint16_t)){
 		debugPrintf("%s(): Failed receive pipe count",__func__);
@@ -1071,6 +3121,8 @@ static int receiveNodeProperties(nodeData* node){
 			debugPrintf("%s(): Failed receive pipe type",__func__);
 			return -1;
 		}	
+		node->pipes[i].option = node->pipes[i].type & ~NODE_PIPE_TYPE_MASK;
+		node->pipes[i].type &= NODE_PIPE_TYPE_MASK;
 
 		//unit
 		if(fileReadWithTimeOut(node->fd[0],&node->pipes[i].unit,sizeof(uint8_t),1000000LL) != sizeof(uint8_t)){
@@ -1083,6 +3135,12 @@ static int receiveNodeProperties(nodeData* node){
 			debugPrintf("%s(): Failed receive array length",__func__);
 			return -1;
 		}	
+
+		//depth
+		if(fileReadWithTimeOut(node->fd[0],&node->pipes[i].depth,sizeof(uint16_t),1000000LL) != sizeof(uint16_t) || node->pipes[i].depth == 0){
+			debugPrintf("%s(): Failed receive stream depth",__func__);
+			return -1;
+		}	
 		
 		//name
 		res = fileReadStrWithTimeOut(node->fd[0],recvBuffer,sizeof(recvBuffer),1000000LL);
@@ -1119,13 +3177,26 @@ static int receiveNodeProperties(nodeData* node){
 }
 
 static void pipeAddNode(){
+	//nodeSystemBegine of the node is served by nodeSystemLoop
+	int res = -1;
+	nodeData* data = nodeSpawn();
+	if(data != NULL && nodeStartWait(&data,&res,1,NODE_START_BEGIN) > 0)
+		nodeLevelUpdate();
+
+	ctrlWrite(&res,sizeof(res));	
+}
+
+static nodeData* nodeSpawn(){
 	//init struct
 	nodeData* data = malloc(sizeof(nodeData));
 	memset(data,0,sizeof(nodeData));
+	data->divisor = 1;
+	data->slot = -1;
+	data->errFd = -1;
 
 	//get path
 	char path[PATH_MAX];
-	fileReadStr(fd[0],path,sizeof(path));
+	ctrlReadStr(path,sizeof(path));
 	data->filePath = malloc(strlen(path)+1);
 	strcpy(data->filePath,path);
 	data->name = strrchr(data->filePath,'/');
@@ -1136,98 +3207,296 @@ static void pipeAddNode(){
 
 	//args count
 	uint16_t argsCount;
-	fileRead(fd[0],&argsCount,sizeof(argsCount));
+	ctrlRead(&argsCount,sizeof(argsCount));
 
 	//load args
 	char** args = malloc(sizeof(char*)*argsCount);
 	int i;
 	for(i = 0;i < argsCount;i++){
 		args[i] = malloc(PATH_MAX);
-		fileReadStr(fd[0],args[i],PATH_MAX);
+		ctrlReadStr(args[i],PATH_MAX);
 		char* newPtr = realloc(args[i],strlen(args[i])+1);
 		if(newPtr != NULL)
 			args[i] = newPtr;
 	}
 	
-	//do args
+	//do args (whole vector is given to node)
 	for(i = 0;i < (argsCount-1);i++){
 		if(strcmp(args[i],"-name") == 0){
-			free(args[i++]);
-			data->name = args[i];
-		}else{
-			free(args[i]);
+			i++;
+			data->name = strdup(args[i]);
+		}else if(strcmp(args[i],"-divisor") == 0){
+			i++;
+			int divisor = atoi(args[i]);
+			data->divisor = divisor > 0 ? divisor : 1;
+		}else if(strcmp(args[i],"-cpu") == 0){
+			i++;
+			free(data->cpuList);
+			data->cpuList = strdup(args[i]);
+		}else if(strcmp(args[i],"-sched") == 0){
+			i++;
+			int p;
+			for(p = 0;p < sizeof(NODE_SCHED_POLICY_STR)/sizeof(NODE_SCHED_POLICY_STR[0]);p++){
+				if(strcmp(args[i],NODE_SCHED_POLICY_STR[p]) == 0)
+					data->policy = p;
+			}
+		}else if(strcmp(args[i],"-priority") == 0){
+			i++;
+			data->priority = atoi(args[i]);
+		}else if(strcmp(args[i],"-runtime") == 0){
+			i++;
+			data->runtime = atof(args[i]);
+		}else if(strcmp(args[i],"-period") == 0){
+			//nearest multiple of base period
+			i++;
+			double divisor = atof(args[i]) / systemSettingMemory->period + 0.5;
+			data->divisor = divisor >= 1 ? (uint32_t)divisor : 1;
+			if(data->divisor * systemSettingMemory->period != atof(args[i]))
+				debugPrintf("%s(): period %sms is rounded to %lfms",__func__,args[i],data->divisor * systemSettingMemory->period);
+		}else if(strcmp(args[i],"-env") == 0){
+			i++;
+			if(strchr(args[i],'=') == NULL){
+				debugPrintf("%s(): -env %s is not NAME=VALUE",__func__,args[i]);
+				continue;
+			}
+			data->env = realloc(data->env,sizeof(char*) * (data->envCount + 1));
+			data->env[data->envCount++] = strdup(args[i]);
 		}
 	}
 
+	//argv of node (leading path is not repeated)
+	char** argv = malloc(sizeof(char*) * (argsCount + 2));
+	int argc = 0;
+	argv[argc++] = data->filePath;
+	for(i = (argsCount > 0 && strcmp(args[0],data->filePath) == 0);i < argsCount;i++)
+		argv[argc++] = args[i];
+	argv[argc] = NULL;
+
+	//name conflict (starting nodes are indexed too)
+	if(nodeFind(data->name) != NULL){
+		debugPrintf("%s(): name conflict",__func__);
+		data->pid = 0;
+	}else{
+		//execute program
+		char** envp = nodeEnvBuild(data);
+		data->pid = envp ? popenRWasNonBlock(data->filePath,argv,envp,data->fd) : -1;
+		free(envp);
+		if(data->pid < 0)
+			debugPrintf("%s(): Failed execute file",__func__);
+	}
+
 	//free
+	for(i = 0;i < argsCount;i++)
+		free(args[i]);
 	free(args);
+	free(argv);
 
-	//check name conflict
-	int f = 0;
-	nodeData** itr;
-	LINEAR_LIST_FOREACH(inactiveNodeList,itr){
-		if(strcmp((*itr)->name,data->name) == 0)
-			f =1;
-		else if(f)
-			break;
+	if(data->pid <= 0){
+		data->pid = 0;
+		nodeStartFail(data);
+		return NULL;
 	}
-	LINEAR_LIST_FOREACH(activeNodeList,itr){
-		if(strcmp((*itr)->name,data->name) == 0)
-			f =1;
-		else if(f)
-			break;
+
+	//stderr log next to node log
+	if(!systemSettingMemory->isNoLog){
+		sprintf(path,"%s/%s.stderr.txt",logFolder,data->name);
+		data->errFd = open(path,O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,0666);
+		if(data->errFd < 0)
+			debugPrintf("%s(): [%s]: open(): %s",__func__,data->name,strerror(errno));
 	}
 
-	//name conflict
-	if(f){
-		debugPrintf("%s(): name conflict",__func__);
+	//stderr is drained from spawn on (also while other nodes start)
+	eventAdd(errEpollFd,data->fd[2],data,EVENT_NODE_ERR);
 
-		//free
-		if((data->name < data->filePath) || (data->name > (data->filePath+strlen(data->filePath))))
-			free(data->name);
-		free(data->filePath);
-		free(data);
+	struct timespec spec;
+	clock_gettime(CLOCK_MONOTONIC,&spec);
+	data->startTime = spec.tv_sec * 1000000000ULL + spec.tv_nsec;
+	data->startPhase = NODE_START_HEAD;
+	nodeIndexAdd(data);
 
-		int res = -1;
-		fileWrite(fd[1],&res,sizeof(res));
-		return;
+	return data;
+}
+
+static void nodeStartFail(nodeData* node){
+	//node was not given to any list
+	if(node->pid > 0){
+		kill(node->pid,SIGTERM);
+		nodeIndexRemove(node);
+		close(node->fd[0]);
+		close(node->fd[1]);
+		close(node->fd[2]);
 	}
+	if(node->errFd >= 0)
+		close(node->errFd);
+	free(node->errBuffer);
 
-	//execute program
-	data->pid = popenRWasNonBlock(data->filePath,data->fd);
-	if(data->pid < 0){
-		debugPrintf("%s(): Failed execute file",__func__);
-		
-		//free
-		if((data->name < data->filePath) || (data->name > (data->filePath+strlen(data->filePath))))
-			free(data->name);
-		free(data->filePath);
-		free(data);
+	int i;
+	for(i = 0;i < node->pipeCount && node->pipes;i++)
+		free(node->pipes[i].pipeName);
+	free(node->pipes);
+	for(i = 0;i < node->envCount;i++)
+		free(node->env[i]);
+	free(node->env);
+	if((node->name < node->filePath) || (node->name > (node->filePath+strlen(node->filePath))))
+		free(node->name);
+	free(node->filePath);
+	free(node->cpuList);
+	free(node);
+}
 
-		int res = -1;
-		fileWrite(fd[1],&res,sizeof(res));
-		return;
+static int nodeStartWait(nodeData** nodes,int* results,int count,uint8_t until){
+	//drive handshake of every starting node at once up to phase until (caller updates level)
+	int activeCount = 0;
+	struct pollfd* fds = malloc(sizeof(struct pollfd) * (count + 1));
+	int* owner = malloc(sizeof(int) * (count + 1));
+
+	int i;
+	for(i = 0;i < count;i++)
+		results[i] = -1;
+
+	//every spawned node fails
+	if(fds == NULL || owner == NULL){
+		debugPrintf("%s(): malloc(): %s",__func__,strerror(errno));
+		for(i = 0;i < count;i++)
+			nodeStartFail(nodes[i]);
+		free(fds);
+		free(owner);
+		return 0;
 	}
 
-	
-	//load properties
-	if(receiveNodeProperties(data)){
-		kill(data->pid,SIGTERM);
-		//free
-		if((data->name < data->filePath) || (data->name > (data->filePath+strlen(data->filePath))))
-			free(data->name);
-		free(data->filePath);
-		free(data);
+	struct timespec spec;
+	clock_gettime(CLOCK_MONOTONIC,&spec);
+	uint64_t now = spec.tv_sec * 1000000000ULL + spec.tv_nsec;
+	uint64_t limit = now + NODE_START_TIMEOUT_MS * 1000000ULL;
+	while(1){
+		//stderr of every node, then handshake output of unfinished nodes
+		int n = 0;
+		fds[n] = (struct pollfd){.fd = errEpollFd,.events = POLLIN};
+		owner[n++] = -1;
+		for(i = 0;i < count;i++){
+			if(nodes[i] == NULL || nodes[i]->startPhase >= until)
+				continue;
+			fds[n] = (struct pollfd){.fd = nodes[i]->fd[0],.events = POLLIN};
+			owner[n++] = i;
+		}
+		if(n == 1 || now >= limit)
+			break;
 
-		int res = -1;
-		fileWrite(fd[1],&res,sizeof(res));
-		return;
+		struct timespec timeout = {.tv_sec = (limit - now) / 1000000000ULL,.tv_nsec = (limit - now) % 1000000000ULL};
+		int ready = ppoll(fds,n,&timeout,NULL);
+		if(ready < 0 && errno != EINTR){
+			debugPrintf("%s(): ppoll(): %s",__func__,strerror(errno));
+			break;
+		}
+		clock_gettime(CLOCK_MONOTONIC,&spec);
+		now = spec.tv_sec * 1000000000ULL + spec.tv_nsec;
+
+		//stderr never blocks start up (closed stderr leaves errEpollFd)
+		if(ready > 0 && fds[0].revents != 0)
+			nodeErrPoll();
+
+		int k;
+		for(k = 1;k < n && ready > 0;k++){
+			nodeData* node = nodes[owner[k]];
+			if(fds[k].revents == 0 || node == NULL)
+				continue;
+			int* res = &results[owner[k]];
+
+			//next phase of handshake
+			int ret = 0;
+			switch(node->startPhase){
+				case NODE_START_HEAD:
+					ret = receiveNodeHead(node);
+					node->startPhase = NODE_START_PROPERTY;
+					break;
+				case NODE_START_PROPERTY:
+					ret = receiveNodePipes(node);
+					if(ret == 0){
+						LINEAR_LIST_PUSH(inactiveNodeList,node);
+						pipeIndexBuild(node);
+						eventAdd(epollFd,node->fd[0],node,EVENT_NODE_BEGIN);
+						node->startPhase = NODE_START_BEGIN;
+						*res = 0;
+					}
+					break;
+				case NODE_START_BEGIN:
+					ret = nodeBegin(node);
+					if(ret == 0){
+						nodeActivate(node);
+						node->startPhase = NODE_START_DONE;
+						activeCount++;
+						debugPrintf("%s(): [%s]: started in %lfms",__func__,node->name,(now - node->startTime) / 1000000.0);
+					}else if(ret > 0 && (fds[k].revents & (POLLHUP | POLLERR))){
+						//closed before handshake (SIGCHLD cleans up)
+						epoll_ctl(epollFd,EPOLL_CTL_DEL,node->fd[0],NULL);
+						node->startPhase = NODE_START_DONE;
+					}
+					ret = ret < 0 ? -1 : 0;
+					break;
+			}
+
+			if(ret != 0){
+				debugPrintf("%s(): [%s]: failed start",__func__,node->name);
+				if(node->startPhase == NODE_START_BEGIN){
+					//same as failed handshake in nodeSystemLoop
+					nodeData** itr;
+					LINEAR_LIST_FOREACH(inactiveNodeList,itr){
+						if(*itr == node){
+							kill(node->pid,SIGTERM);
+							nodeDeleate(node);
+							LINEAR_LIST_ERASE(itr);
+							break;
+						}
+					}
+				}else{
+					nodeStartFail(node);
+				}
+				nodes[owner[k]] = NULL;
+				*res = -1;
+			}
+
+			//progress extends time limit
+			limit = now + NODE_START_TIMEOUT_MS * 1000000ULL;
+		}
 	}
-	else
-		LINEAR_LIST_PUSH(inactiveNodeList,data);
 
-	int res = 0;
-	fileWrite(fd[1],&res,sizeof(res));	
+	//nodes without init header in time are dropped, late nodeSystemBegine is served by nodeSystemLoop
+	for(i = 0;i < count;i++){
+		if(nodes[i] == NULL)
+			continue;
+		if(nodes[i]->startPhase < NODE_START_BEGIN){
+			debugPrintf("%s(): [%s]: start timed out",__func__,nodes[i]->name);
+			nodeStartFail(nodes[i]);
+			results[i] = -1;
+		}
+	}
+
+	free(fds);
+	free(owner);
+	return activeCount;
+}
+
+static void nodeActivate(nodeData* node){
+	nodeData** itr;
+	LINEAR_LIST_FOREACH(inactiveNodeList,itr){
+		if(*itr == node){
+			LINEAR_LIST_ERASE(itr);
+			break;
+		}
+	}
+	LINEAR_LIST_PUSH(activeNodeList,node);
+	node->isActive = 1;
+	node->startPhase = NODE_START_DONE;
+	handleNode[node->slot] = node;
+	epoll_ctl(epollFd,EPOLL_CTL_DEL,node->fd[0],NULL);
+
+	wakeupTable* table = wakeupNodeArray.shmMap;
+	shareMemoryLock(&wakeupNodeArray);
+	table->nodes[node->slot].pid = node->pid;
+	shareMemoryUnLock(&wakeupNodeArray);
+
+	//cpu affinity and scheduling policy after handshake (node keeps running on failure)
+	schedApply(node->pid,node->name,node->cpuList,node->policy,node->priority,node->runtime,systemSettingMemory->period * node->divisor);
 }
 
 static void pipeNodeList(){
@@ -1240,158 +3509,190 @@ static void pipeNodeList(){
 	}
 
 	//send node count
-	fileWrite(fd[1],&nodeCount,sizeof(nodeCount));
+	ctrlWrite(&nodeCount,sizeof(nodeCount));
 	
 	LINEAR_LIST_FOREACH(activeNodeList,itr){
 		//send node name
-		fileWriteStr(fd[1],(*itr)->name);
+		ctrlWriteStr((*itr)->name);
 		
 		//send file path
-		fileWriteStr(fd[1],(*itr)->filePath);
+		ctrlWriteStr((*itr)->filePath);
 
 		//send pipe count
-		fileWrite(fd[1],&(*itr)->pipeCount,sizeof((*itr)->pipeCount));
+		ctrlWrite(&(*itr)->pipeCount,sizeof((*itr)->pipeCount));
 		
 		int i;
 		for(i = 0;i < (*itr)->pipeCount;i++){
 			//semd pipe data
-			fileWriteStr(fd[1],(*itr)->pipes[i].pipeName);
-			fileWrite(fd[1],&(*itr)->pipes[i].type,sizeof((*itr)->pipes[i].type));
-			fileWrite(fd[1],&(*itr)->pipes[i].unit,sizeof((*itr)->pipes[i].unit));
-			fileWrite(fd[1],&(*itr)->pipes[i].length,sizeof((*itr)->pipes[i].length));
+			ctrlWriteStr((*itr)->pipes[i].pipeName);
+			ctrlWrite(&(*itr)->pipes[i].type,sizeof((*itr)->pipes[i].type));
+			ctrlWrite(&(*itr)->pipes[i].unit,sizeof((*itr)->pipes[i].unit));
+			ctrlWrite(&(*itr)->pipes[i].length,sizeof((*itr)->pipes[i].length));
 
 			//send state
-			uint8_t isConnected = (*itr)->pipes[i].connectPipe != NULL;
-			fileWrite(fd[1],&isConnected,sizeof(isConnected));
-
-			if(isConnected){
+			uint16_t connectCount = (*itr)->pipes[i].connectPipe != NULL;
+			if((*itr)->pipes[i].type == NODE_PIPE_MERGE)
+				connectCount = (*itr)->pipes[i].mergeCount;
+			ctrlWrite(&connectCount,sizeof(connectCount));
+
+			if((*itr)->pipes[i].type == NODE_PIPE_MERGE){
+				//send all source node and pipe
+				int j;
+				for(j = 0;j < connectCount;j++){
+					ctrlWriteStr((*itr)->pipes[i].mergeNode[j]);
+					ctrlWriteStr((*itr)->pipes[i].mergePipe[j]);
+				}
+			}else if(connectCount){
 				//send connect node and pipe
-				fileWriteStr(fd[1],(*itr)->pipes[i].connectNode);
-				fileWriteStr(fd[1],(*itr)->pipes[i].connectPipe);
+				ctrlWriteStr((*itr)->pipes[i].connectNode);
+				ctrlWriteStr((*itr)->pipes[i].connectPipe);
 			}
 		}
 	}
 }
 
 static void pipeNodeConnect(){
+	int res = connectReceive();
+	if(res == 0){
+		nodeEventNotify();
+		nodeLevelUpdate();
+	}
+
+	//send result
+	ctrlWrite(&res,sizeof(res));
+}
+
+static void pipeNodeDisConnect(){
+	int res = disConnectReceive();
+	if(res == 0){
+		nodeEventNotify();
+		nodeLevelUpdate();
+	}
+
+	//send result
+	ctrlWrite(&res,sizeof(res));
+}
+
+static int connectReceive(){
 	char inNode[PATH_MAX];
 	char inPipe[PATH_MAX];
 	char outNode[PATH_MAX];
 	char outPipe[PATH_MAX];
 	
 	//receive in pipe
-	fileReadStr(fd[0],inNode,PATH_MAX);
-	fileReadStr(fd[0],inPipe,PATH_MAX);
+	ctrlReadStr(inNode,PATH_MAX);
+	ctrlReadStr(inPipe,PATH_MAX);
 
 	//receive out pipe
-	fileReadStr(fd[0],outNode,PATH_MAX);
-	fileReadStr(fd[0],outPipe,PATH_MAX);
+	ctrlReadStr(outNode,PATH_MAX);
+	ctrlReadStr(outPipe,PATH_MAX);
 
 	//finde pipe
-	nodePipe* in = NULL,*out = NULL;
 	nodeData *node_in = NULL,*node_out = NULL;
-	uint16_t pipe_in = 0;
-	shm_key* outputMem = NULL;
+	uint16_t pipe_in = 0,pipe_out = 0;
 
-	nodeData** itr;
-	LINEAR_LIST_FOREACH(activeNodeList,itr){
-		if(strcmp((*itr)->name,inNode) == 0){
-			node_in = *itr;
-			//find in pipe
-			int i;
-			for(i = 0;i < (*itr)->pipeCount;i++){
-				if(strcmp((*itr)->pipes[i].pipeName,inPipe) == 0){
-					pipe_in = i;
-					in = &(*itr)->pipes[i];
-					break;
-				}
-			}
-		}
-
-		if(strcmp((*itr)->name,outNode) == 0){
-			node_out = *itr;
-			//find out pipe
-			int i;
-			for(i = 0;i < (*itr)->pipeCount;i++){
-				if(strcmp((*itr)->pipes[i].pipeName,outPipe) == 0){
-					outputMem = &(*itr)->pipes[i].shm;
-					out = &(*itr)->pipes[i];
-					break;
-				}
-			}
-		}
-	}
-
-	int res = 0;
-	if(in == NULL || out == NULL){
+	if(pipeFind(inNode,inPipe,&node_in,&pipe_in) == NULL || pipeFind(outNode,outPipe,&node_out,&pipe_out) == NULL){
 		debugPrintf("%s(): Pipe not found",__func__);
-		res = -1;
-	}else if(in->type != NODE_PIPE_IN || out->type != NODE_PIPE_OUT || in->unit != out->unit || in->length != out->length){
-		debugPrintf("%s(): Pipe type is invalid",__func__);
-		res = -1;
-	}else{
-		fileWrite(node_in->fd[1],&pipe_in,sizeof(pipe_in));
-		fileWrite(node_in->fd[1],&outputMem->semId,sizeof(outputMem->semId));
-		fileWrite(node_in->fd[1],&outputMem->shmId,sizeof(outputMem->shmId));
-		in->connectNode = node_out->name;
-		in->connectPipe = out->pipeName;
-
-		debugPrintf("%s(): Connect %s %s to %s %s",__func__,inNode,inPipe,outNode,outPipe);
+		return -1;
 	}
 
-	//send result
-	fileWrite(fd[1],&res,sizeof(res));
+	return nodeConnect(node_in,pipe_in,node_out,pipe_out);
 }
 
-static void pipeNodeDisConnect(){
+static int disConnectReceive(){
 	char inNode[PATH_MAX];
 	char inPipe[PATH_MAX];
 	
 	//receive in pipe
-	fileReadStr(fd[0],inNode,PATH_MAX);
-	fileReadStr(fd[0],inPipe,PATH_MAX);
+	ctrlReadStr(inNode,PATH_MAX);
+	ctrlReadStr(inPipe,PATH_MAX);
 
 	//finde pipe
-	nodePipe* in = NULL;
 	nodeData *node_in = NULL;
 	uint16_t pipe_in = 0;
-	shm_key outputMem = {};
 
-	nodeData** itr;
-	LINEAR_LIST_FOREACH(activeNodeList,itr){
-		if(strcmp((*itr)->name,inNode) == 0){
-			node_in = *itr;
-			//find in pipe
-			int i;
-			for(i = 0;i < (*itr)->pipeCount;i++){
-				if(strcmp((*itr)->pipes[i].pipeName,inPipe) == 0){
-					pipe_in = i;
-					in = &(*itr)->pipes[i];
-					break;
-				}
+	if(pipeFind(inNode,inPipe,&node_in,&pipe_in) == NULL){
+		debugPrintf("%s(): Pipe not found",__func__);
+		return -1;
+	}
+
+	return nodeDisConnect(node_in,pipe_in);
+}
+
+static int nodeConnect(nodeData* node_in,uint16_t pipe_in,nodeData* node_out,uint16_t pipe_out){
+	//caller notifies nodes and updates level (once per batch)
+	nodePipe* in = &node_in->pipes[pipe_in];
+	nodePipe* out = &node_out->pipes[pipe_out];
+
+	if((in->type != NODE_PIPE_IN && in->type != NODE_PIPE_MERGE) || (out->type != NODE_PIPE_OUT && out->type != NODE_PIPE_STREAM) || in->unit != out->unit || in->length != out->length){
+		debugPrintf("%s(): Pipe type is invalid",__func__);
+		return -1;
+	}
+
+	if(in->type == NODE_PIPE_MERGE){
+		//source is already merged
+		int i;
+		for(i = 0;i < in->mergeCount;i++){
+			if(in->mergeNode[i] == node_out->name && in->mergePipe[i] == out->pipeName){
+				debugPrintf("%s(): %s %s is already connected to %s %s",__func__,node_out->name,out->pipeName,node_in->name,in->pipeName);
+				return -1;
 			}
 		}
+
+		char** mergeNode = realloc(in->mergeNode,sizeof(char*)*(in->mergeCount+1));
+		if(mergeNode == NULL){
+			debugPrintf("%s(): realloc failed",__func__);
+			return -1;
+		}
+		in->mergeNode = mergeNode;
+
+		char** mergePipe = realloc(in->mergePipe,sizeof(char*)*(in->mergeCount+1));
+		if(mergePipe == NULL){
+			debugPrintf("%s(): realloc failed",__func__);
+			return -1;
+		}
+		in->mergePipe = mergePipe;
 	}
 
-	int res = 0;
-	if(in == NULL){
-		debugPrintf("%s(): Pipe not found",__func__);
-		res = -1;
-	}else if(in->type != NODE_PIPE_IN){
-		debugPrintf("%s(): Pipe type is invalid",__func__);
-		res = -1;
+	fileWrite(node_in->fd[1],&pipe_in,sizeof(pipe_in));
+	shareMemorySendKey(node_in->fd[1],&out->shm);
+	if(in->type == NODE_PIPE_MERGE){
+		//add source
+		in->mergeNode[in->mergeCount] = node_out->name;
+		in->mergePipe[in->mergeCount] = out->pipeName;
+		in->mergeCount++;
 	}else{
-		fileWrite(node_in->fd[1],&pipe_in,sizeof(pipe_in));
-		fileWrite(node_in->fd[1],&outputMem.semId,sizeof(outputMem.semId));
-		fileWrite(node_in->fd[1],&outputMem.shmId,sizeof(outputMem.shmId));
-		in->connectNode = NULL;
-		in->connectPipe = NULL;
+		in->connectNode = node_out->name;
+		in->connectPipe = out->pipeName;
+	}
+
+	debugPrintf("%s(): Connect %s %s to %s %s",__func__,node_in->name,in->pipeName,node_out->name,out->pipeName);
+	return 0;
+}
+
+static int nodeDisConnect(nodeData* node_in,uint16_t pipe_in){
+	nodePipe* in = &node_in->pipes[pipe_in];
+	shm_key outputMem = {};
 
-		debugPrintf("%s(): Disconnect %s %s",__func__,inNode,inPipe);
+	if(in->type != NODE_PIPE_IN && in->type != NODE_PIPE_MERGE){
+		debugPrintf("%s(): Pipe type is invalid",__func__);
+		return -1;
 	}
 
-	//send result
-	write(fd[1],&res,sizeof(res));
+	fileWrite(node_in->fd[1],&pipe_in,sizeof(pipe_in));
+	shareMemorySendKey(node_in->fd[1],&outputMem);
+	in->connectNode = NULL;
+	in->connectPipe = NULL;
+
+	//remove all source
+	free(in->mergeNode);
+	free(in->mergePipe);
+	in->mergeNode = NULL;
+	in->mergePipe = NULL;
+	in->mergeCount = 0;
+
+	debugPrintf("%s(): Disconnect %s %s",__func__,node_in->name,in->pipeName);
+	return 0;
 }
 
 static void pipeNodeSetConst(){
@@ -1399,29 +3700,17 @@ static void pipeNodeSetConst(){
 	char constPipe[PATH_MAX];
 	
 	//receive in pipe
-	fileReadStr(fd[0],constNode,PATH_MAX);
-	fileReadStr(fd[0],constPipe,PATH_MAX);
+	ctrlReadStr(constNode,PATH_MAX);
+	ctrlReadStr(constPipe,PATH_MAX);
 
 	//recive value count
 	int count;
-	fileRead(fd[0],&count,sizeof(count));
+	ctrlRead(&count,sizeof(count));
 
 	//finde pipe
 	nodePipe* pipe_const = NULL;
 
-	nodeData** itr;
-	LINEAR_LIST_FOREACH(activeNodeList,itr){
-		if(strcmp((*itr)->name,constNode) == 0){
-			//find in pipe
-			int i;
-			for(i = 0;i < (*itr)->pipeCount;i++){
-				if(strcmp((*itr)->pipes[i].pipeName,constPipe) == 0){
-					pipe_const = &(*itr)->pipes[i];
-					break;
-				}
-			}
-		}
-	}
+	pipe_const = pipeFind(constNode,constPipe,NULL,NULL);
 
 	int res = 0;
 	if(pipe_const == NULL){
@@ -1433,110 +3722,127 @@ static void pipeNodeSetConst(){
 	}
 
 	//send result
-	fileWrite(fd[1],&res,sizeof(res));
+	ctrlWrite(&res,sizeof(res));
 
 	if(res == 0){
-		uint16_t size = NODE_DATA_UNIT_SIZE[pipe_const->unit];
-		void* tmpBuffer = malloc(size*pipe_const->length);
-		int flag = 1;
+		res = constRead(pipe_const,count);
+
+		//send result
+		ctrlWrite(&res,sizeof(res));
+	}
+}
+
+static int constRead(nodePipe* pipe_const,int count){
+	char constValueStr[PATH_MAX];
+
+	if(pipe_const != NULL && (pipe_const->type != NODE_PIPE_CONST || pipe_const->length != count)){
+		debugPrintf("%s(): Pipe type is invalid",__func__);
+		pipe_const = NULL;
+	}
+
+	//discard values of invalid pipe
+	if(pipe_const == NULL){
+		int i;
+		for(i = 0;i < count;i++)
+			ctrlReadStr(constValueStr,PATH_MAX);
+		return -1;
+	}
 
-		char constValueStr[PATH_MAX];
-		//read data
-		switch(pipe_const->unit){
-			case NODE_UNIT_CHAR:{
-				int i;
-				for(i = 0;i < count;i++){
-					fileReadStr(fd[0],constValueStr,PATH_MAX);
-					flag &= sscanf(constValueStr,"%c",&((char*)tmpBuffer)[i]);
-				}
+	uint16_t size = NODE_DATA_UNIT_SIZE[pipe_const->unit];
+	void* tmpBuffer = malloc(size*pipe_const->length);
+	int flag = 1;
+
+	//read data
+	switch(pipe_const->unit){
+		case NODE_UNIT_CHAR:{
+			int i;
+			for(i = 0;i < count;i++){
+				ctrlReadStr(constValueStr,PATH_MAX);
+				flag &= sscanf(constValueStr,"%c",&((char*)tmpBuffer)[i]);
 			}
-			break;
-			case NODE_UNIT_BOOL:{
-				int i;
-				for(i = 0;i < count;i++){
-					fileReadStr(fd[0],constValueStr,PATH_MAX);
-					int isTrue;
-					flag &= sscanf(constValueStr,"%d",&isTrue);
-					((uint8_t*)tmpBuffer)[i] = (isTrue != 0);
-				}
+		}
+		break;
+		case NODE_UNIT_BOOL:{
+			int i;
+			for(i = 0;i < count;i++){
+				ctrlReadStr(constValueStr,PATH_MAX);
+				int isTrue;
+				flag &= sscanf(constValueStr,"%d",&isTrue);
+				((uint8_t*)tmpBuffer)[i] = (isTrue != 0);
 			}
-			break;
-			case NODE_UNIT_INT8:
-			case NODE_UNIT_INT16:
-			case NODE_UNIT_INT32:
-			case NODE_UNIT_INT64:{
-				int i;
-				for(i = 0;i < count;i++){
-					fileReadStr(fd[0],constValueStr,PATH_MAX);
-					long value;
-					flag &= sscanf(constValueStr,"%ld",&value);
-					memcpy(tmpBuffer+i*size,&value,size);
-					if(value < 0 && (((-1l)<<size*8)&~value))
-						flag = 0;
-					else if(value > 0 && ((-1l)<<size*8)&value)
-						flag = 0;
-				}
+		}
+		break;
+		case NODE_UNIT_INT8:
+		case NODE_UNIT_INT16:
+		case NODE_UNIT_INT32:
+		case NODE_UNIT_INT64:{
+			int i;
+			for(i = 0;i < count;i++){
+				ctrlReadStr(constValueStr,PATH_MAX);
+				long value;
+				flag &= sscanf(constValueStr,"%ld",&value);
+				memcpy(tmpBuffer+i*size,&value,size);
+				if(value < 0 && (((-1l)<<size*8)&~value))
+					flag = 0;
+				else if(value > 0 && ((-1l)<<size*8)&value)
+					flag = 0;
 			}
-			break;
-			case NODE_UNIT_UINT8:
-			case NODE_UNIT_UINT16:
-			case NODE_UNIT_UINT32:
-			case NODE_UNIT_UINT64:{
-				int i;
-				for(i = 0;i < count;i++){
-					fileReadStr(fd[0],constValueStr,PATH_MAX);
-					unsigned long value;
-					flag &= sscanf(constValueStr,"%lu",&value);
-					memcpy(tmpBuffer+i*size,&value,size);
-					if(((-1l)<<size*8)&value)
-						flag = 0;
-				}
+		}
+		break;
+		case NODE_UNIT_UINT8:
+		case NODE_UNIT_UINT16:
+		case NODE_UNIT_UINT32:
+		case NODE_UNIT_UINT64:{
+			int i;
+			for(i = 0;i < count;i++){
+				ctrlReadStr(constValueStr,PATH_MAX);
+				unsigned long value;
+				flag &= sscanf(constValueStr,"%lu",&value);
+				memcpy(tmpBuffer+i*size,&value,size);
+				if(((-1l)<<size*8)&value)
+					flag = 0;
 			}
-			break;
-			case NODE_UNIT_FLOAT:{
-				int i;
-				for(i = 0;i < count;i++){
-					fileReadStr(fd[0],constValueStr,PATH_MAX);
-					flag &= sscanf(constValueStr,"%f",&((float*)tmpBuffer)[i]);
-				}
+		}
+		break;
+		case NODE_UNIT_FLOAT:{
+			int i;
+			for(i = 0;i < count;i++){
+				ctrlReadStr(constValueStr,PATH_MAX);
+				flag &= sscanf(constValueStr,"%f",&((float*)tmpBuffer)[i]);
 			}
-			break;
-			case NODE_UNIT_DOUBLE:{
-				int i;
-				for(i = 0;i < count;i++){
-					fileReadStr(fd[0],constValueStr,PATH_MAX);
-					flag &= sscanf(constValueStr,"%lf",&((double*)tmpBuffer)[i]);
-				}
+		}
+		break;
+		case NODE_UNIT_DOUBLE:{
+			int i;
+			for(i = 0;i < count;i++){
+				ctrlReadStr(constValueStr,PATH_MAX);
+				flag &= sscanf(constValueStr,"%lf",&((double*)tmpBuffer)[i]);
 			}
-			break;
-			
 		}
+		break;
+		
+	}
 
-		res = 0;
-		if(flag == 0){
-			debugPrintf("%s(): Input data is invalid",__func__);
+	int res = 0;
+	if(flag == 0){
+		debugPrintf("%s(): Input data is invalid",__func__);
+		res = -1;
+	}else{
+		//cpy data
+		if(shareMemoryOpen(&pipe_const->shm,0)  == 0){
+			pipeMemoryWrite(&pipe_const->shm,tmpBuffer,size*pipe_const->length);
+			shareMemoryClose(&pipe_const->shm);
+		}
+		else{
+			debugPrintf("%s(): Failed open memory",__func__);
 			res = -1;
-		}else{
-			//cpy data
-			if(shareMemoryOpen(&pipe_const->shm,0)  == 0){
-				shareMemoryLock(&pipe_const->shm);
-				((uint8_t*)pipe_const->shm.shmMap)[0]++;
-				memcpy(pipe_const->shm.shmMap+1,tmpBuffer,size*pipe_const->length);
-				shareMemoryUnLock(&pipe_const->shm);
-				shareMemoryClose(&pipe_const->shm);
-			}
-			else{
-				debugPrintf("%s(): Failed open memory",__func__);
-				res = -1;
-			}
 		}
+	}
 
-		//free
-		free(tmpBuffer);
+	//free
+	free(tmpBuffer);
 
-		//send result
-		fileWrite(fd[1],&res,sizeof(res));
-	}
+	return res;
 }
 
 static void pipeNodeGetConst(){
@@ -1544,27 +3850,14 @@ static void pipeNodeGetConst(){
 	char constPipe[PATH_MAX];
 	
 	//receive in pipe
-	size_t len;
-	fileReadStr(fd[0],constNode,PATH_MAX);
-	fileReadStr(fd[0],constPipe,PATH_MAX);
+	ctrlReadStr(constNode,PATH_MAX);
+	ctrlReadStr(constPipe,PATH_MAX);
 
-	//finde pipe
-	nodePipe* pipe_const = NULL;
-
-	nodeData** itr;
-	LINEAR_LIST_FOREACH(activeNodeList,itr){
-		if(strcmp((*itr)->name,constNode) == 0){
-			//find in pipe
-			int i;
-			for(i = 0;i < (*itr)->pipeCount;i++){
-				if(strcmp((*itr)->pipes[i].pipeName,constPipe) == 0){
-					pipe_const = &(*itr)->pipes[i];
-					break;
-				}
-			}
-		}
-	}
+	//finde pipe and send value
+	constSend(pipeFind(constNode,constPipe,NULL,NULL));
+}
 
+static void constSend(nodePipe* pipe_const){
 	int res = 0;
 
 	if(pipe_const == NULL){
@@ -1581,30 +3874,34 @@ static void pipeNodeGetConst(){
 	}
 
 	//send result
-	fileWrite(fd[1],&res,sizeof(res));
+	ctrlWrite(&res,sizeof(res));
 
 
 	//send value
 	if(res > 0){
 		char value[1024];
 		uint16_t size = NODE_DATA_UNIT_SIZE[pipe_const->unit];
-		void* memory = pipe_const->shm.shmMap;
+		void* memory = malloc(size*pipe_const->length);
+
+		//copy data
+		pipeMemoryRead(&pipe_const->shm,memory,size*pipe_const->length,NULL);
+		shareMemoryClose(&pipe_const->shm);
 
 		//read data
 		switch(pipe_const->unit){
 			case NODE_UNIT_CHAR:{
 				int i;
 				for(i = 0;i < pipe_const->length;i++){
-					sprintf(value,"%c",((char*)memory)[i+1]);
-					fileWriteStr(fd[1],value);
+					sprintf(value,"%c",((char*)memory)[i]);
+					ctrlWriteStr(value);
 				}
 			}
 			break;
 			case NODE_UNIT_BOOL:{
 				int i;
 				for(i = 0;i < pipe_const->length;i++){
-					sprintf(value,"%d",(int)((char*)memory)[i+1]);
-					fileWriteStr(fd[1],value);
+					sprintf(value,"%d",(int)((char*)memory)[i]);
+					ctrlWriteStr(value);
 				}
 			}
 			break;
@@ -1615,7 +3912,7 @@ static void pipeNodeGetConst(){
 				int i;
 				for(i = 0;i < pipe_const->length;i++){
 					long num = 0;
-					memcpy(&num,memory + 1 + i*size,size);
+					memcpy(&num,memory + i*size,size);
 
 					//if num is neg fill head to 0xFF 
 					int j;
@@ -1625,7 +3922,7 @@ static void pipeNodeGetConst(){
 					}
 
 					sprintf(value,"%ld",num);
-					fileWriteStr(fd[1],value);
+					ctrlWriteStr(value);
 				}
 			}
 			break;
@@ -1636,31 +3933,31 @@ static void pipeNodeGetConst(){
 				int i;
 				for(i = 0;i < pipe_const->length;i++){
 					unsigned long num = 0;
-					memcpy(&num,memory + 1 + i*size,size);
+					memcpy(&num,memory + i*size,size);
 					sprintf(value,"%lu",num);
-					fileWriteStr(fd[1],value);
+					ctrlWriteStr(value);
 				}
 			}
 			break;
 			case NODE_UNIT_FLOAT:{
 				int i;
 				for(i = 0;i < pipe_const->length;i++){
-					sprintf(value,"%f",((float*)(memory + 1))[i]);
-					fileWriteStr(fd[1],value);
+					sprintf(value,"%f",((float*)memory)[i]);
+					ctrlWriteStr(value);
 				}
 			}
 			break;
 			case NODE_UNIT_DOUBLE:{
 				int i;
 				for(i = 0;i < pipe_const->length;i++){
-					sprintf(value,"%lf",((double*)(memory + 1))[i]);
-					fileWriteStr(fd[1],value);
+					sprintf(value,"%lf",((double*)memory)[i]);
+					ctrlWriteStr(value);
 				}
 			}
 			break;	
 		}
 
-		shareMemoryClose(&pipe_const->shm);
+		free(memory);
 	}
 }
 
@@ -1674,7 +3971,7 @@ static void pipeSave(){
 	int res = 0;
 
 	//receive file path
-	fileReadStr(fd[0],saveFilePath,PATH_MAX);
+	ctrlReadStr(saveFilePath,PATH_MAX);
 
 	saveFile = fopen(saveFilePath,"w");
 	if(saveFile != NULL){
@@ -1682,6 +3979,30 @@ static void pipeSave(){
 			//save filepath and name
 			fprintf(saveFile,"%s\n",(*itr)->filePath);
 			fprintf(saveFile,"%s\n",(*itr)->name);
+
+			//save launch option (one line, no length limit)
+			uint8_t isFirst = 1;
+			char num[64];
+			if((*itr)->divisor != 1){
+				sprintf(num,"%u",(*itr)->divisor);
+				optionWrite(saveFile,&isFirst,"-divisor",num);
+			}
+			if((*itr)->cpuList)
+				optionWrite(saveFile,&isFirst,"-cpu",(*itr)->cpuList);
+			if((*itr)->policy != NODE_SCHED_OTHER){
+				sprintf(num,"%d",(*itr)->priority);
+				optionWrite(saveFile,&isFirst,"-sched",NODE_SCHED_POLICY_STR[(*itr)->policy]);
+				optionWrite(saveFile,&isFirst,"-priority",num);
+			}
+			if((*itr)->policy == NODE_SCHED_DEADLINE && (*itr)->runtime > 0){
+				sprintf(num,"%lf",(*itr)->runtime);
+				optionWrite(saveFile,&isFirst,"-runtime",num);
+			}
+			int e;
+			for(e = 0;e < (*itr)->envCount;e++)
+				optionWrite(saveFile,&isFirst,"-env",(*itr)->env[e]);
+			if(!isFirst)
+				fprintf(saveFile,"\n");
 		}
 
 		//insert space
@@ -1696,6 +4017,15 @@ static void pipeSave(){
 					fprintf(saveFile,"%s\n",(*itr)->pipes[i].pipeName);
 					fprintf(saveFile,"%s\n",(*itr)->pipes[i].connectNode);
 					fprintf(saveFile,"%s\n",(*itr)->pipes[i].connectPipe);
+				}else if((*itr)->pipes[i].type == NODE_PIPE_MERGE){
+					//one relation per source
+					int j;
+					for(j = 0;j < (*itr)->pipes[i].mergeCount;j++){
+						fprintf(saveFile,"%s\n",(*itr)->name);
+						fprintf(saveFile,"%s\n",(*itr)->pipes[i].pipeName);
+						fprintf(saveFile,"%s\n",(*itr)->pipes[i].mergeNode[j]);
+						fprintf(saveFile,"%s\n",(*itr)->pipes[i].mergePipe[j]);
+					}
 				}
 			}
 		}
@@ -1712,14 +4042,16 @@ static void pipeSave(){
 					fprintf(saveFile,"%s\n",(*itr)->pipes[i].pipeName);
 					
 
-					void* mem;
+					size_t size = (*itr)->pipes[i].length*NODE_DATA_UNIT_SIZE[(*itr)->pipes[i].unit];
+					void* mem = malloc(size);
 					if(shareMemoryOpen(&(*itr)->pipes[i].shm,0) == 0){
-						shareMemoryLock(&(*itr)->pipes[i].shm);
-						fprintf(saveFile,"%d\n",(*itr)->pipes[i].length*NODE_DATA_UNIT_SIZE[(*itr)->pipes[i].unit]);
-						fwrite((*itr)->pipes[i].shm.shmMap+1,NODE_DATA_UNIT_SIZE[(*itr)->pipes[i].unit],(*itr)->pipes[i].length,saveFile);
-						shareMemoryUnLock(&(*itr)->pipes[i].shm);
+						pipeMemoryRead(&(*itr)->pipes[i].shm,mem,size,NULL);
 						shareMemoryClose(&(*itr)->pipes[i].shm);
+						fprintf(saveFile,"%d\n",(int)size);
+						fwrite(mem,size,1,saveFile);
+						free(mem);
 					}else{
+						free(mem);
 						res = -1;
 						debugPrintf("%s(): [%s.%s]: Failed open shared memory\n",__func__,(*itr)->name,(*itr)->pipes[i].pipeName);
 					}
@@ -1736,40 +4068,40 @@ static void pipeSave(){
 
 
 	//send result
-	fileWrite(fd[1],&res,sizeof(res));
+	ctrlWrite(&res,sizeof(res));
 }
 
 static void pipeLoad(){
+	int res = constLoadReceive();
+
+	//send result
+	ctrlWrite(&res,sizeof(res));
+}
+
+static int constLoadReceive(){
 	char nodeName[PATH_MAX];
 	char pipeName[PATH_MAX];
-	int size;
+	uint32_t size;
 
 	//recive node name pipe name
-	fileReadStr(fd[0],nodeName,PATH_MAX);
-	fileReadStr(fd[0],pipeName,PATH_MAX);
+	ctrlReadStr(nodeName,PATH_MAX);
+	ctrlReadStr(pipeName,PATH_MAX);
 
 	debugPrintf("%s(): load const pipe \nNode:%s\nPipe:%s",__func__,nodeName,pipeName);
-	//receive data
-	fileRead(fd[0],&size,sizeof(size));
-	void* mem = malloc(size);
-	fileRead(fd[0],mem,size);
+	//receive data (skipped when it can not be held)
+	ctrlRead(&size,sizeof(size));
+	void* mem = malloc(size ? size : 1);
+	if(mem == NULL){
+		debugPrintf("%s(): malloc(): %s",__func__,strerror(errno));
+		ctrlSkip(size);
+		return -1;
+	}
+	ctrlRead(mem,size);
 
 	//finde pipe
 	nodePipe* pipe_const = NULL;
 
-	nodeData** itr;
-	LINEAR_LIST_FOREACH(activeNodeList,itr){
-		if(strcmp((*itr)->name,nodeName) == 0){
-			//find in pipe
-			int i;
-			for(i = 0;i < (*itr)->pipeCount;i++){
-				if(strcmp((*itr)->pipes[i].pipeName,pipeName) == 0){
-					pipe_const = &(*itr)->pipes[i];
-					break;
-				}
-			}
-		}
-	}
+	pipe_const = pipeFind(nodeName,pipeName,NULL,NULL);
 
 	int res = 0;
 
@@ -1785,10 +4117,7 @@ static void pipeLoad(){
 			debugPrintf("%s(): Failed open shared memory",__func__);
 			res = -1;
 		}else{
-			shareMemoryLock(&pipe_const->shm);
-			((uint8_t*)pipe_const->shm.shmMap)[0]++;
-			memcpy(pipe_const->shm.shmMap+1,mem,size);
-			shareMemoryUnLock(&pipe_const->shm);
+			pipeMemoryWrite(&pipe_const->shm,mem,size);
 			shareMemoryClose(&pipe_const->shm);
 		}
 	}
@@ -1796,50 +4125,212 @@ static void pipeLoad(){
 	//free
 	free(mem);
 
-	//send result
-	fileWrite(fd[1],&res,sizeof(res));
+	return res;
 }
 
 static void pipeTimerRun(){
 	shareMemoryLock(&wakeupNodeArray);
-	((int*)wakeupNodeArray.shmMap)[0] = 1;
+	wakeupTable* table = wakeupNodeArray.shmMap;
+	table->isRun = 1;
+	memset(&table->stat,0,sizeof(table->stat));
+	uint32_t i;
+	for(i = 0;i < table->count;i++){
+		table->nodes[i].overrun = 0;
+		table->nodes[i].lateMax = 0;
+		table->nodes[i].execMax = 0;
+		table->nodes[i].wakeupMax = 0;
+		memset(table->nodes[i].execHist,0,sizeof(table->nodes[i].execHist));
+		memset(table->nodes[i].wakeupHist,0,sizeof(table->nodes[i].wakeupHist));
+	}
 	shareMemoryUnLock(&wakeupNodeArray);
 }
 
 static void pipeTimerStop(){
 	shareMemoryLock(&wakeupNodeArray);
-	((int*)wakeupNodeArray.shmMap)[0] = 0;
+	((wakeupTable*)wakeupNodeArray.shmMap)->isRun = 0;
 	shareMemoryUnLock(&wakeupNodeArray);
 }
 
 static void pipeTimerSet(){	
-	fileRead(fd[0],&systemSettingMemory->period,sizeof(systemSettingMemory->period));
+	ctrlRead(&systemSettingMemory->period,sizeof(systemSettingMemory->period));
 	
 	//copy data
 	shareMemoryLock(&systemSettingKey);
 	memcpy(systemSettingKey.shmMap,systemSettingMemory,sizeof(nodeSystemEnv));
 	shareMemoryUnLock(&systemSettingKey);
+
+	nodeEventNotify();
 }
 
 static void pipeTimerGet(){
-	fileWrite(fd[1],&systemSettingMemory->period,sizeof(systemSettingMemory->period));
+	ctrlWrite(&systemSettingMemory->period,sizeof(systemSettingMemory->period));
+}
+
+static void pipeTimerPolicy(){
+	uint8_t policy;
+	ctrlRead(&policy,sizeof(policy));
+
+	shareMemoryLock(&wakeupNodeArray);
+	((wakeupTable*)wakeupNodeArray.shmMap)->policy = policy;
+	shareMemoryUnLock(&wakeupNodeArray);
+}
+
+static void pipeTimerStat(){
+	timerStat stat;
+
+	shareMemoryLock(&wakeupNodeArray);
+	stat = ((wakeupTable*)wakeupNodeArray.shmMap)->stat;
+	shareMemoryUnLock(&wakeupNodeArray);
+
+	ctrlWrite(&stat,sizeof(stat));
+}
+
+static void pipeTimerSched(){
+	char cpuList[PATH_MAX];
+	uint8_t policy;
+	int priority;
+
+	//receive cpu list and policy
+	ctrlReadStr(cpuList,PATH_MAX);
+	ctrlRead(&policy,sizeof(policy));
+	ctrlRead(&priority,sizeof(priority));
+
+	int res = schedApply(timerPid,"timer",cpuList,policy,priority,0,systemSettingMemory->period);
+
+	//send result
+	ctrlWrite(&res,sizeof(res));
+}
+
+static void pipeNodeStat(){
+	char nodeName[PATH_MAX];
+	wakeupSlot slot = {};
+
+	//receive node name
+	ctrlReadStr(nodeName,PATH_MAX);
+
+	int res = -1;
+	nodeData* node = nodeFind(nodeName);
+	if(node != NULL && node->isActive){
+		shareMemoryLock(&wakeupNodeArray);
+		slot = ((wakeupTable*)wakeupNodeArray.shmMap)->nodes[node->slot];
+		shareMemoryUnLock(&wakeupNodeArray);
+		res = 0;
+	}
+
+	if(res != 0)
+		debugPrintf("%s(): Node not found",__func__);
+	else if(slot.overrun != 0)
+		debugPrintf("%s(): [%s]: %lu overrun, worst lateness %lfms",__func__,nodeName,slot.overrun,slot.lateMax / 1000000.0);
+
+	//send result and slot
+	ctrlWrite(&res,sizeof(res));
+	ctrlWrite(&slot,sizeof(slot));
+}
+
+static void pipeGetPipeStat(){
+	char nodeName[PATH_MAX];
+	char pipeName[PATH_MAX];
+	pipeWriteMetric write = {};
+	pipeReadMetric read = {};
+
+	//receive pipe
+	ctrlReadStr(nodeName,PATH_MAX);
+	ctrlReadStr(pipeName,PATH_MAX);
+
+	//find pipe (in pipe reports its source)
+	nodePipe* pipe = NULL;
+	int res = -1;
+	int retry;
+	for(retry = 0;retry < 2 && pipe == NULL;retry++){
+		pipe = pipeFind(nodeName,pipeName,NULL,NULL);
+		if(pipe != NULL && pipe->type == NODE_PIPE_IN){
+			if(pipe->connectNode == NULL || pipe->connectPipe == NULL){
+				debugPrintf("%s(): [%s.%s]: Pipe is not connected",__func__,nodeName,pipeName);
+				pipe = NULL;
+				break;
+			}
+			strcpy(nodeName,pipe->connectNode);
+			strcpy(pipeName,pipe->connectPipe);
+			pipe = NULL;
+		}
+	}
+
+	if(pipe == NULL){
+		debugPrintf("%s(): Pipe not found",__func__);
+	}else if(pipe->type == NODE_PIPE_MERGE){
+		debugPrintf("%s(): [%s.%s]: Merge pipe has no own memory",__func__,nodeName,pipeName);
+	}else if(shareMemoryOpen(&pipe->shm,SHM_RDONLY) != 0){
+		debugPrintf("%s(): Failed open shared memory",__func__);
+	}else{
+		//counters are only added, relaxed copy is enough
+		pipeWriteMetric* w = PIPE_WRITE_METRIC(pipe->shm.shmMap);
+		pipeReadMetric* r = PIPE_READ_METRIC(pipe->shm.shmMap);
+		write.writes = __atomic_load_n(&w->writes,__ATOMIC_RELAXED);
+		write.bytes = __atomic_load_n(&w->bytes,__ATOMIC_RELAXED);
+		write.lockCount = __atomic_load_n(&w->lockCount,__ATOMIC_RELAXED);
+		write.lockWaitSum = __atomic_load_n(&w->lockWaitSum,__ATOMIC_RELAXED);
+		write.lockWaitMax = __atomic_load_n(&w->lockWaitMax,__ATOMIC_RELAXED);
+		read.reads = __atomic_load_n(&r->reads,__ATOMIC_RELAXED);
+		read.bytes = __atomic_load_n(&r->bytes,__ATOMIC_RELAXED);
+		read.unchanged = __atomic_load_n(&r->unchanged,__ATOMIC_RELAXED);
+		read.skipped = __atomic_load_n(&r->skipped,__ATOMIC_RELAXED);
+		shareMemoryClose(&pipe->shm);
+		res = 0;
+	}
+
+	//send result and metrics
+	ctrlWrite(&res,sizeof(res));
+	ctrlWrite(&write,sizeof(write));
+	ctrlWrite(&read,sizeof(read));
+}
+
+static void pipeTimerDivisor(){
+	char nodeName[PATH_MAX];
+	uint32_t divisor;
+
+	//receive node name and divisor
+	ctrlReadStr(nodeName,PATH_MAX);
+	ctrlRead(&divisor,sizeof(divisor));
+
+	int res = -1;
+	nodeData* node = nodeFind(nodeName);
+	if(node != NULL && node->isActive){
+		node->divisor = divisor;
+		shareMemoryLock(&wakeupNodeArray);
+		((wakeupTable*)wakeupNodeArray.shmMap)->nodes[node->slot].divisor = divisor;
+		shareMemoryUnLock(&wakeupNodeArray);
+		res = 0;
+	}
+
+	if(res != 0)
+		debugPrintf("%s(): Node not found",__func__);
+
+	//send result
+	ctrlWrite(&res,sizeof(res));
 }
 
 static void pipeKill(){
 	//get nodeName
 	char nodeName[PATH_MAX];
-	fileReadStr(fd[0],nodeName,PATH_MAX);
+	ctrlReadStr(nodeName,PATH_MAX);
+
+	nodeData* node = nodeFind(nodeName);
+	if(node != NULL && node->isActive)
+		nodeKill(node);
+}
 
-	//deleate
+static void nodeKill(nodeData* node){
+	//deleate (list is walked only to erase)
 	nodeData** itr;
 	LINEAR_LIST_FOREACH(activeNodeList,itr){
-		if(strcmp((*itr)->name,nodeName) == 0){
+		if(*itr == node){
 			//kill
 			kill((*itr)->pid,SIGTERM);
 			//deleate node
 			nodeDeleate(*itr);
 			//deleate from list
 			LINEAR_LIST_ERASE(itr);
+			nodeLevelUpdate();
 			break;
 		}
 	}
@@ -1852,7 +4343,7 @@ static void pipeCheckFile(){
 
 	//get path
 	char path[PATH_MAX];
-	fileReadStr(fd[0],path,sizeof(path));
+	ctrlReadStr(path,sizeof(path));
 	data->filePath = malloc(strlen(path)+1);
 	strcpy(data->filePath,path);
 	data->name = strrchr(data->filePath,'/');
@@ -1862,7 +4353,8 @@ static void pipeCheckFile(){
 		data->name = data->filePath;
 	
 	//execute program
-	data->pid = popenRWasNonBlock(data->filePath,data->fd);
+	char* argv[] = {data->filePath,NULL};
+	data->pid = popenRWasNonBlock(data->filePath,argv,environ,data->fd);
 	if(data->pid < 0){
 		debugPrintf("%s(): Failed execute file",__func__);
 		
@@ -1873,7 +4365,7 @@ static void pipeCheckFile(){
 		free(data);
 
 		int res = -1;
-		fileWrite(fd[1],&res,sizeof(res));
+		ctrlWrite(&res,sizeof(res));
 		return;
 	}
 
@@ -1881,6 +4373,9 @@ static void pipeCheckFile(){
 	//load properties
 	if(receiveNodeProperties(data)){
 		kill(data->pid,SIGTERM);
+		close(data->fd[0]);
+		close(data->fd[1]);
+		close(data->fd[2]);
 		//free
 		if((data->name < data->filePath) || (data->name > (data->filePath+strlen(data->filePath))))
 			free(data->name);
@@ -1888,11 +4383,14 @@ static void pipeCheckFile(){
 		free(data);
 
 		int res = -1;
-		fileWrite(fd[1],&res,sizeof(res));
+		ctrlWrite(&res,sizeof(res));
 		return;
 	}
 	else{
 		kill(data->pid,SIGTERM);
+		close(data->fd[0]);
+		close(data->fd[1]);
+		close(data->fd[2]);
 		//free
 		if((data->name < data->filePath) || (data->name > (data->filePath+strlen(data->filePath))))
 			free(data->name);
@@ -1900,7 +4398,7 @@ static void pipeCheckFile(){
 		free(data);
 
 		int res = 0;
-		fileWrite(fd[1],&res,sizeof(res));
+		ctrlWrite(&res,sizeof(res));
 		return;
 	}
 }
@@ -1915,43 +4413,313 @@ static void pipeGetNodeNameList(){
 	}
 
 	//send node count
-	fileWrite(fd[1],&nodeCount,sizeof(nodeCount));
+	ctrlWrite(&nodeCount,sizeof(nodeCount));
 	
 	LINEAR_LIST_FOREACH(activeNodeList,itr){
 		//send node name
-		fileWriteStr(fd[1],(*itr)->name);
+		ctrlWriteStr((*itr)->name);
 	}
 }
 
 static void pipeGetPipeNameList(){
-	uint16_t nodeCount = 0;
-	nodeData** itr;
 	char nodeName[PATH_MAX];
 	size_t len;
 
 	//get node name
-	fileReadStr(fd[0],nodeName,PATH_MAX);
+	ctrlReadStr(nodeName,PATH_MAX);
 	
 	//get node count
-	LINEAR_LIST_FOREACH(activeNodeList,itr){
-		if(strcmp((*itr)->name,nodeName) == 0){
-			//send pipe count
-			fileWrite(fd[1],&(*itr)->pipeCount,sizeof((*itr)->pipeCount));
+	nodeData* node = nodeFind(nodeName);
+	if(node != NULL && node->isActive){
+		//send pipe count
+		ctrlWrite(&node->pipeCount,sizeof(node->pipeCount));
+
+		int i;
+		for(i = 0;i < node->pipeCount;i++){
+			//send pipe name
+			ctrlWriteStr(node->pipes[i].pipeName);
+		}
+
+		return;
+	}
+
+
+	//if node is not found
+	uint16_t zero = 0;
+	ctrlWrite(&zero,sizeof(zero));
+}
+
+static void pipeResolve(){
+	char nodeName[PATH_MAX];
+	char pipeName[PATH_MAX];
+
+	//receive node name and pipe name (empty: node handle)
+	ctrlReadStr(nodeName,PATH_MAX);
+	ctrlReadStr(pipeName,PATH_MAX);
+
+	NODE_HANDLE handle = 0;
+	nodeData* node = NULL;
+	uint16_t index;
+	if(pipeName[0] == '\0'){
+		node = nodeFind(nodeName);
+		if(node != NULL && node->isActive)
+			handle = handleMake(node,-1);
+		else
+			debugPrintf("%s(): Node not found",__func__);
+	}else if(pipeFind(nodeName,pipeName,&node,&index) != NULL){
+		handle = handleMake(node,index);
+	}else{
+		debugPrintf("%s(): Pipe not found",__func__);
+	}
+
+	//send handle
+	ctrlWrite(&handle,sizeof(handle));
+}
+
+static void pipeHandleConnect(){
+	int res = handleConnectReceive();
+	if(res == 0){
+		nodeEventNotify();
+		nodeLevelUpdate();
+	}
+
+	//send result
+	ctrlWrite(&res,sizeof(res));
+}
+
+static void pipeHandleDisConnect(){
+	int res = handleDisConnectReceive();
+	if(res == 0){
+		nodeEventNotify();
+		nodeLevelUpdate();
+	}
+
+	//send result
+	ctrlWrite(&res,sizeof(res));
+}
+
+static void pipeHandleSetConst(){
+	int res = handleConstSetReceive();
+
+	//send result
+	ctrlWrite(&res,sizeof(res));
+}
+
+static int handleConnectReceive(){
+	NODE_HANDLE inPipe,outPipe;
+
+	//receive handle
+	ctrlRead(&inPipe,sizeof(inPipe));
+	ctrlRead(&outPipe,sizeof(outPipe));
+
+	nodeData *node_in,*node_out;
+	uint16_t pipe_in,pipe_out;
+
+	node_in = handleFind(inPipe,&pipe_in);
+	node_out = handleFind(outPipe,&pipe_out);
+	if(node_in == NULL || node_out == NULL)
+		return -1;
+
+	return nodeConnect(node_in,pipe_in,node_out,pipe_out);
+}
+
+static int handleDisConnectReceive(){
+	NODE_HANDLE inPipe;
+
+	//receive handle
+	ctrlRead(&inPipe,sizeof(inPipe));
+
+	uint16_t pipe_in;
+	nodeData* node_in = handleFind(inPipe,&pipe_in);
+	if(node_in == NULL)
+		return -1;
+
+	return nodeDisConnect(node_in,pipe_in);
+}
+
+static int handleConstSetReceive(){
+	NODE_HANDLE constPipe;
+	int count;
+
+	//receive handle and value count (values follow in same message)
+	ctrlRead(&constPipe,sizeof(constPipe));
+	ctrlRead(&count,sizeof(count));
+
+	uint16_t index;
+	nodeData* node = handleFind(constPipe,&index);
+
+	return constRead(node != NULL ? &node->pipes[index] : NULL,count);
+}
+
+static int constSetReceive(){
+	char constNode[PATH_MAX];
+	char constPipe[PATH_MAX];
+	int count;
+
+	//receive const pipe and value count (values follow in same message)
+	ctrlReadStr(constNode,PATH_MAX);
+	ctrlReadStr(constPipe,PATH_MAX);
+	ctrlRead(&count,sizeof(count));
+
+	nodePipe* pipe_const = pipeFind(constNode,constPipe,NULL,NULL);
+	if(pipe_const == NULL)
+		debugPrintf("%s(): Pipe not found",__func__);
+
+	return constRead(pipe_const,count);
+}
+
+static void pipeBatch(){
+	uint32_t count;
+	ctrlRead(&count,sizeof(count));
+
+	//nodes are spawned back to back and started together before next other operation
+	int* results = malloc(sizeof(int) * (count ? count : 1));
+	nodeData** starting = malloc(sizeof(nodeData*) * (count ? count : 1));
+	uint32_t* startIndex = malloc(sizeof(uint32_t) * (count ? count : 1));
+	int* startResults = malloc(sizeof(int) * (count ? count : 1));
+	uint32_t startCount = 0;
+	if(!results || !starting || !startIndex || !startResults){
+		debugPrintf("%s(): malloc(): %s",__func__,strerror(errno));
+		free(results);
+		free(starting);
+		free(startIndex);
+		free(startResults);
+
+		//every operation fails
+		ctrlSkip(ctrlInFrame);
+		int res = -1;
+		ctrlWrite(&count,sizeof(count));
+		uint32_t i;
+		for(i = 0;i < count;i++)
+			ctrlWrite(&res,sizeof(res));
+		return;
+	}
+
+	//apply every operation, notify nodes and update level once
+	uint8_t isChanged = 0;
+	uint32_t i;
+	for(i = 0;i <= count;i++){
+		uint8_t op = 0xFF;
+		if(i < count)
+			ctrlRead(&op,sizeof(op));
+
+		if(op == PIPE_ADD_NODE){
+			results[i] = -1;
+			nodeData* node = nodeSpawn();
+			if(node != NULL){
+				starting[startCount] = node;
+				startIndex[startCount++] = i;
+			}
+			continue;
+		}
+		if(startCount != 0){
+			uint32_t j;
+			isChanged |= nodeStartWait(starting,startResults,startCount,NODE_START_DONE) > 0;
+			for(j = 0;j < startCount;j++)
+				results[startIndex[j]] = startResults[j];
+			startCount = 0;
+		}
+		if(i == count)
+			break;
+
+		switch(op){
+			case PIPE_NODE_CONNECT:
+				results[i] = connectReceive();
+				isChanged |= (results[i] == 0);
+				break;
+			case PIPE_NODE_DISCONNECT:
+				results[i] = disConnectReceive();
+				isChanged |= (results[i] == 0);
+				break;
+			case PIPE_HANDLE_CONNECT:
+				results[i] = handleConnectReceive();
+				isChanged |= (results[i] == 0);
+				break;
+			case PIPE_HANDLE_DISCONNECT:
+				results[i] = handleDisConnectReceive();
+				isChanged |= (results[i] == 0);
+				break;
+			case PIPE_NODE_SET_CONST:
+				results[i] = constSetReceive();
+				break;
+			case PIPE_HANDLE_SET_CONST:
+				results[i] = handleConstSetReceive();
+				break;
+			case PIPE_LOAD:
+				results[i] = constLoadReceive();
+				break;
+			default:{
+				//rest of batch can not be parsed
+				debugPrintf("%s(): Invalid operation %d",__func__,op);
+				ctrlSkip(ctrlInFrame);
+				for(;i < count;i++)
+					results[i] = -1;
+			}
+			break;
+		}
+	}
+
+	free(starting);
+	free(startIndex);
+	free(startResults);
+
+	if(isChanged){
+		nodeEventNotify();
+		nodeLevelUpdate();
+	}
+
+	//send per operation result
+	ctrlWrite(&count,sizeof(count));
+	ctrlWrite(results,sizeof(int) * count);
+	free(results);
+}
+
+static void pipeHandleGetConst(){
+	NODE_HANDLE constPipe;
+
+	//receive handle
+	ctrlRead(&constPipe,sizeof(constPipe));
 
-			int i;
-			for(i = 0;i < (*itr)->pipeCount;i++){
-				//send pipe name
-				fileWriteStr(fd[1],(*itr)->pipes[i].pipeName);
-			}
+	uint16_t index;
+	nodeData* node = handleFind(constPipe,&index);
+	constSend(node != NULL ? &node->pipes[index] : NULL);
+}
 
-			return;
-		}
+static void pipeHandleKill(){
+	NODE_HANDLE killNode;
+
+	//receive handle
+	ctrlRead(&killNode,sizeof(killNode));
+
+	int res = -1;
+	nodeData* node = handleFind(killNode,NULL);
+	if(node != NULL){
+		nodeKill(node);
+		res = 0;
 	}
 
+	//send result
+	ctrlWrite(&res,sizeof(res));
+}
 
-	//if node is not found
-	uint16_t zero = 0;
-	fileWrite(fd[1],&zero,sizeof(zero));
+static void pipeSetEnv(){
+	char name[PATH_MAX];
+	char value[PATH_MAX];
+	uint8_t isSet;
+
+	//receive name and value
+	ctrlReadStr(name,PATH_MAX);
+	ctrlRead(&isSet,sizeof(isSet));
+	if(isSet)
+		ctrlReadStr(value,PATH_MAX);
+
+	//environment of manager is given to nodes started later
+	int res = isSet ? setenv(name,value,1) : unsetenv(name);
+	if(res != 0)
+		debugPrintf("%s(): %s: %s",__func__,name,strerror(errno));
+
+	//send result
+	ctrlWrite(&res,sizeof(res));
 }
 
 static void pipeExit(){
@@ -1959,14 +4727,18 @@ static void pipeExit(){
 	nodeData** itr;
 	LINEAR_LIST_FOREACH(activeNodeList,itr){
 		nodeDeleate(*itr);
+		LINEAR_LIST_ERASE(itr);
 	}
 	
 	int res = 0;
 	//dleate mem
 	shareMemoryDeleate(&systemSettingKey);
 	shareMemoryDeleate(&wakeupNodeArray);
+	if(pipeArena.size)
+		shareMemoryDeleate(&pipeArena);
 
-	fileWrite(fd[1],&res,sizeof(res));
+	ctrlWrite(&res,sizeof(res));
+	ctrlFlush();
 	exit(0);
 }
 
@@ -1975,10 +4747,20 @@ static void pipeExit(){
 typedef struct{
 	shm_key shm;
 	char* pipeName;
-	uint8_t count;
+	uint64_t count;
 	uint8_t type;
+	uint8_t option;
 	uint8_t unit;
 	uint16_t length;
+	uint16_t depth;
+	uint64_t cursor;
+	uint64_t lost;
+	uint64_t loan;
+	pipeStamp loanStamp;
+	uint8_t isLoaned;
+	uint16_t sourceCount;
+	shm_key* sources;
+	uint64_t* sourceCounts;
 } _node_pipe;
 
 static uint8_t _nodeSystemIsActive = 0;
@@ -1988,6 +4770,19 @@ static uint16_t _pipe_count = 0;
 static _node_pipe* _pipes = NULL;
 static int _self;
 static int _parent;
+static uint32_t _eventCount = 0;
+static shm_key _wakeupKey;
+static int32_t _slot = -1;
+static uint64_t _resumeTime = 0;	//CLOCK_MONOTONIC at last resume [ns]
+
+//local func
+static void pipeMetricRead(shm_key* shm,size_t bytes,uint64_t last,uint64_t sequence);
+static int fileReadStr(int fd,char* str,ssize_t size);
+static int histIndex(uint64_t value);
+static int futexWait(struct futex_waitv* waits,int count,const struct timespec* deadline);
+static int fileRead(   int fd,void* buf,ssize_t size);
+static int shareMemoryRecvKey(int fd,shm_key* shm);
+static int pipeStreamRead(shm_key* shm,void* buf,size_t size,uint16_t maxCount,uint64_t* cursor,uint64_t* lost);
 
 int nodeSystemInit(){
 	//Check system state
@@ -2004,9 +4799,14 @@ int nodeSystemInit(){
 	fileWrite(STDOUT_FILENO,&_node_init_head,sizeof(_node_init_head));
 
 	//read system Env
-	fileRead(STDIN_FILENO,&systemSettingKey.semId,sizeof(int));
-	fileRead(STDIN_FILENO,&systemSettingKey.shmId,sizeof(int));
+	shareMemoryRecvKey(STDIN_FILENO,&systemSettingKey);
+	shareMemoryRecvKey(STDIN_FILENO,&pipeArena);
 	shareMemoryOpen(&systemSettingKey,SHM_RDONLY);
+
+	//map pipe arena once
+	if(pipeArena.size != 0 && shareMemoryOpen(&pipeArena,0) != 0)
+		return -1;
+
 	systemSettingMemory = malloc(sizeof(nodeSystemEnv));
 	shareMemoryLock(&systemSettingKey);
 	memcpy(systemSettingMemory,systemSettingKey.shmMap,sizeof(nodeSystemEnv));
@@ -2039,9 +4839,11 @@ int nodeSystemInit(){
 	//send pipe data
 	uint16_t i;
 	for(i = 0;i < _pipe_count;i++){
-		fileWrite(STDOUT_FILENO,&_pipes[i].type,sizeof(_pipes[i].type));
+		uint8_t type = _pipes[i].type | _pipes[i].option;
+		fileWrite(STDOUT_FILENO,&type,sizeof(type));
 		fileWrite(STDOUT_FILENO,&_pipes[i].unit,sizeof(_pipes[i].unit));
 		fileWrite(STDOUT_FILENO,&_pipes[i].length,sizeof(_pipes[i].length));
+		fileWrite(STDOUT_FILENO,&_pipes[i].depth,sizeof(_pipes[i].depth));
 		fileWriteStr(STDOUT_FILENO,_pipes[i].pipeName);
 	}
 	
@@ -2076,9 +4878,11 @@ int nodeSystemAddPipe(char* const pipeName,NODE_PIPE_TYPE type,NODE_DATA_UNIT un
 	_node_pipe pipe = {};
 	
 	//cpy data
-	pipe.type = type;
+	pipe.type = type & NODE_PIPE_TYPE_MASK;
+	pipe.option = type & ~NODE_PIPE_TYPE_MASK;
 	pipe.unit = unit;
 	pipe.length = arrayLength;
+	pipe.depth = 1;
 	pipe.pipeName = malloc(strlen(pipeName)+1);
 	if(!pipe.pipeName){
 		return -1;
@@ -2104,6 +4908,24 @@ int nodeSystemAddPipe(char* const pipeName,NODE_PIPE_TYPE type,NODE_DATA_UNIT un
 	return _pipe_count++;
 }
 
+int nodeSystemAddStreamPipe(char* const pipeName,NODE_DATA_UNIT unit,uint16_t arrayLength,uint16_t depth){
+	//check argment
+	if(depth == 0){
+		return -1;
+	}
+
+	//add pipe
+	int pipeID = nodeSystemAddPipe(pipeName,NODE_PIPE_STREAM,unit,arrayLength,NULL);
+	if(pipeID < 0){
+		return -1;
+	}
+
+	//set ring depth
+	_pipes[pipeID].depth = depth;
+
+	return pipeID;
+}
+
 int nodeSystemBegine(){
 	//check system state
 	if(_nodeSystemIsActive != 1){
@@ -2113,14 +4935,20 @@ int nodeSystemBegine(){
 	//send header
 	fileWrite(STDOUT_FILENO,&_node_begin_head,sizeof(_node_begin_head));
 
+	//receive wakeup table and own slot
+	shareMemoryRecvKey(STDIN_FILENO,&_wakeupKey);
+	fileRead(STDIN_FILENO,&_slot,sizeof(_slot));
+	if(shareMemoryOpen(&_wakeupKey,0) != 0){
+		return -1;
+	}
+
 	//receive pipe data
 	uint16_t i;
 	for(i = 0;i < _pipe_count;i++){
 		//if pipe type is not PIPE_IN
 		if(_pipes[i].type != NODE_PIPE_IN){
 			//receive share memory
-			fileRead(STDIN_FILENO,&_pipes[i].shm.semId,sizeof(_pipes[i].shm.semId));
-			fileRead(STDIN_FILENO,&_pipes[i].shm.shmId,sizeof(_pipes[i].shm.shmId));
+			shareMemoryRecvKey(STDIN_FILENO,&_pipes[i].shm);
 			
 			//if pipe type is PIPE_CONST
 			if(_pipes[i].type == NODE_PIPE_CONST){
@@ -2128,20 +4956,16 @@ int nodeSystemBegine(){
 				void* initVal = _pipes[i].shm.shmMap;
 
 				//if attach success
-				if(shareMemoryOpen(&_pipes[i].shm,0) != 0){
+				if(shareMemoryOpen(&_pipes[i].shm,0) == 0){
 					//if initVal is not null
 					if(initVal){
-						//cpy init value
-						memcpy(_pipes[i].shm.shmMap+1,initVal,
+						//cpy init value and increment write counter
+						pipeMemoryWrite(&_pipes[i].shm,initVal,
 							NODE_DATA_UNIT_SIZE[_pipes[i].unit]*_pipes[i].length);
-						//increment write counter
-						((uint8_t*)_pipes[i].shm.shmMap)[0]++;
 						//free
 						free(initVal);
 					}
-					//dettach and attach sheare memory for read 
-					shareMemoryClose(&_pipes[i].shm);
-					shareMemoryOpen(&_pipes[i].shm,SHM_RDONLY);
+					//keep writable mapping (reader registers futex waiter in header)
 				}
 			}
 			else{
@@ -2171,28 +4995,80 @@ int nodeSystemBegine(){
 
 int nodeSystemLoop(){
 	uint16_t  pipeId;
+
+	//event count before reading message
+	uint32_t event = __atomic_load_n(&((nodeSystemEnv*)systemSettingKey.shmMap)->event,__ATOMIC_ACQUIRE);
 	
-	//if 
-	if(fileReadWithTimeOut(STDIN_FILENO,&pipeId,sizeof(pipeId),1) == sizeof(uint16_t)){
+	//drain pending messages (a merge update is several messages)
+	while(fileReadWithTimeOut(STDIN_FILENO,&pipeId,sizeof(pipeId),1) == sizeof(uint16_t)){
+		if(_pipes[pipeId].type == NODE_PIPE_MERGE){
+			shm_key source = {};
+			shareMemoryRecvKey(STDIN_FILENO,&source);
+
+			if(source.size != 0){
+				//add source
+				shareMemoryOpen(&source,0);
+				if(source.shmMap != NULL && ((pipeHead*)source.shmMap)->version == PIPE_HEAD_VERSION){
+					_pipes[pipeId].sources = realloc(_pipes[pipeId].sources,sizeof(shm_key)*(_pipes[pipeId].sourceCount+1));
+					_pipes[pipeId].sourceCounts = realloc(_pipes[pipeId].sourceCounts,sizeof(uint64_t)*(_pipes[pipeId].sourceCount+1));
+					_pipes[pipeId].sources[_pipes[pipeId].sourceCount] = source;
+					_pipes[pipeId].sourceCounts[_pipes[pipeId].sourceCount] = 0;
+					_pipes[pipeId].sourceCount++;
+					if(_dMode != NODE_DEBUG_CSV)
+						debugPrintf("%s(): [%s]: Pipe connected",__func__,_pipes[pipeId].pipeName);
+				}else{
+					debugPrintf("%s(): [%s]: Failed open shared memory",__func__,_pipes[pipeId].pipeName);
+					if(source.shmMap != NULL)
+						shareMemoryClose(&source);
+				}
+			}else{
+				//remove all source
+				int i;
+				for(i = 0;i < _pipes[pipeId].sourceCount;i++){
+					shareMemoryClose(&_pipes[pipeId].sources[i]);
+				}
+				free(_pipes[pipeId].sources);
+				free(_pipes[pipeId].sourceCounts);
+				_pipes[pipeId].sources = NULL;
+				_pipes[pipeId].sourceCounts = NULL;
+				_pipes[pipeId].sourceCount = 0;
+				if(_dMode != NODE_DEBUG_CSV)
+					debugPrintf("%s(): [%s]: Pipe dissconnect",__func__,_pipes[pipeId].pipeName);
+			}
+		}else{
+			if(_pipes[pipeId].shm.shmMap != NULL){
+				if(shareMemoryClose(&_pipes[pipeId].shm) != 0)
+					debugPrintf("%s(): [%s]: Failed close shared memory",__func__,_pipes[pipeId].pipeName);
+			}
 
-		if(_pipes[pipeId].shm.shmMap != NULL){
-			if(shareMemoryClose(&_pipes[pipeId].shm) != 0)
-				debugPrintf("%s(): [%s]: Failed close shared memory",__func__,_pipes[pipeId].pipeName);
-		}
+			_pipes[pipeId].count = 0;
+			_pipes[pipeId].cursor = 0;
+			_pipes[pipeId].isLoaned = 0;
+			shareMemoryRecvKey(STDIN_FILENO,&_pipes[pipeId].shm);
+			if(_pipes[pipeId].shm.size != 0){			
+				shareMemoryOpen(&_pipes[pipeId].shm,0);
+
+				//check header version
+				if(_pipes[pipeId].shm.shmMap != NULL && ((pipeHead*)_pipes[pipeId].shm.shmMap)->version != PIPE_HEAD_VERSION){
+					debugPrintf("%s(): [%s]: Pipe header version is invalid",__func__,_pipes[pipeId].pipeName);
+					shareMemoryClose(&_pipes[pipeId].shm);
+				}
 
-		_pipes[pipeId].count = 0;
-		fileRead(STDIN_FILENO,&_pipes[pipeId].shm.semId,sizeof(_pipes[pipeId].shm.semId));
-		fileRead(STDIN_FILENO,&_pipes[pipeId].shm.shmId,sizeof(_pipes[pipeId].shm.shmId));
-		if(_pipes[pipeId].shm.shmId != 0){			
-			shareMemoryOpen(&_pipes[pipeId].shm,SHM_RDONLY);
-			if(_dMode != NODE_DEBUG_CSV)
-				debugPrintf("%s(): [%s]: Pipe connected",__func__,_pipes[pipeId].pipeName);
-		}else{
-			if(_dMode != NODE_DEBUG_CSV)
-				debugPrintf("%s(): [%s]: Pipe dissconnect",__func__,_pipes[pipeId].pipeName);
+				//stream reader starts at current write index
+				if(_pipes[pipeId].shm.shmMap != NULL)
+					_pipes[pipeId].cursor = __atomic_load_n(&((pipeHead*)_pipes[pipeId].shm.shmMap)->index,__ATOMIC_ACQUIRE);
+				if(_dMode != NODE_DEBUG_CSV)
+					debugPrintf("%s(): [%s]: Pipe connected",__func__,_pipes[pipeId].pipeName);
+			}else{
+				if(_dMode != NODE_DEBUG_CSV)
+					debugPrintf("%s(): [%s]: Pipe dissconnect",__func__,_pipes[pipeId].pipeName);
+			}
 		}
 	}
 
+	//every message is handled
+	_eventCount = event;
+
 	shareMemoryLock(&systemSettingKey);
 	memcpy(systemSettingMemory,systemSettingKey.shmMap,sizeof(nodeSystemEnv));
 	shareMemoryUnLock(&systemSettingKey);
@@ -2227,79 +5103,533 @@ void nodeSystemDebugLog(char* const str){
 	fflush(logFile);
 }
 
-int nodeStstemSetDebugMode(NODE_DEBUG_MODE mode){
-	//check system state
-	if(_nodeSystemIsActive){
-		return -1;
+int nodeStstemSetDebugMode(NODE_DEBUG_MODE mode){
+	//check system state
+	if(_nodeSystemIsActive){
+		return -1;
+	}
+
+	//change mode
+	_dMode = mode;
+
+	return 0;
+}
+
+int nodeSystemRead(int pipeID,void* buffer){
+	return nodeSystemReadInfo(pipeID,buffer,NULL);
+}
+
+int nodeSystemReadInfo(int pipeID,void* buffer,NODE_PIPE_INFO* info){
+	//check system state
+	if(_nodeSystemIsActive != 2){
+		return -1;
+	}
+	
+	//check pipe type
+	if((_pipes[pipeID].shm.shmMap == NULL) || _pipes[pipeID].type == NODE_PIPE_OUT || _pipes[pipeID].type == NODE_PIPE_STREAM)
+		return -1;
+	
+	//copy data and read stamp
+	pipeStamp stamp;
+	if(pipeMemoryRead(&_pipes[pipeID].shm,buffer,NODE_DATA_UNIT_SIZE[_pipes[pipeID].unit] * _pipes[pipeID].length,&stamp) != 0)
+		return -1;
+	pipeMetricRead(&_pipes[pipeID].shm,NODE_DATA_UNIT_SIZE[_pipes[pipeID].unit] * _pipes[pipeID].length,_pipes[pipeID].count,stamp.sequence);
+
+	//set info
+	if(info){
+		info->sequence = stamp.sequence;
+		info->timestamp = stamp.timestamp;
+		info->tick = stamp.tick;
+		info->skipped = 0;
+		if(_pipes[pipeID].count != 0 && stamp.sequence > _pipes[pipeID].count + 1)
+			info->skipped = stamp.sequence - _pipes[pipeID].count - 1;
+	}
+
+	if(stamp.sequence == _pipes[pipeID].count)
+			return 0;
+
+	_pipes[pipeID].count = stamp.sequence;
+	return 1;
+}
+
+int nodeSystemWrite(int pipeID,void* const buffer){
+	//check system state
+	if(_nodeSystemIsActive != 2){
+		return -1;
+	}
+	
+	//check pipe type
+	if(_pipes[pipeID].type != NODE_PIPE_OUT && _pipes[pipeID].type != NODE_PIPE_STREAM)
+		return -1;
+
+	//copy data and increment write counter
+	if(pipeMemoryWrite(&_pipes[pipeID].shm,buffer,NODE_DATA_UNIT_SIZE[_pipes[pipeID].unit] * _pipes[pipeID].length) != 0)
+		return -1;
+
+	return 0;
+}
+
+int nodeSystemReadStream(int pipeID,void* buffer,uint16_t maxCount){
+	//check system state
+	if(_nodeSystemIsActive != 2){
+		return -1;
+	}
+
+	//check pipe type
+	if((_pipes[pipeID].shm.shmMap == NULL) || _pipes[pipeID].type != NODE_PIPE_IN)
+		return -1;
+
+	//drain pending elements
+	size_t size = NODE_DATA_UNIT_SIZE[_pipes[pipeID].unit] * _pipes[pipeID].length;
+	uint64_t lost = _pipes[pipeID].lost;
+	int res = pipeStreamRead(&_pipes[pipeID].shm,buffer,size,maxCount,&_pipes[pipeID].cursor,&_pipes[pipeID].lost);
+	if(res < 0)
+		return res;
+
+	//overwritten elements are skipped
+	pipeReadMetric* metric = PIPE_READ_METRIC(_pipes[pipeID].shm.shmMap);
+	__atomic_add_fetch(&metric->reads,1,__ATOMIC_RELAXED);
+	__atomic_add_fetch(&metric->bytes,size*res,__ATOMIC_RELAXED);
+	if(res == 0)
+		__atomic_add_fetch(&metric->unchanged,1,__ATOMIC_RELAXED);
+	if(_pipes[pipeID].lost != lost)
+		__atomic_add_fetch(&metric->skipped,_pipes[pipeID].lost - lost,__ATOMIC_RELAXED);
+
+	return res;
+}
+
+int nodeSystemReadMerge(int pipeID,void* buffer,uint16_t maxCount,uint8_t* isUpdated){
+	//check system state
+	if(_nodeSystemIsActive != 2){
+		return -1;
+	}
+
+	//check pipe type
+	if(_pipes[pipeID].type != NODE_PIPE_MERGE)
+		return -1;
+
+	//copy every source
+	size_t size = NODE_DATA_UNIT_SIZE[_pipes[pipeID].unit] * _pipes[pipeID].length;
+	int i;
+	for(i = 0;i < _pipes[pipeID].sourceCount && i < maxCount;i++){
+		pipeStamp stamp;
+		if(pipeMemoryRead(&_pipes[pipeID].sources[i],buffer + size*i,size,&stamp) != 0)
+			return -1;
+		pipeMetricRead(&_pipes[pipeID].sources[i],size,_pipes[pipeID].sourceCounts[i],stamp.sequence);
+
+		if(isUpdated)
+			isUpdated[i] = stamp.sequence != _pipes[pipeID].sourceCounts[i];
+		_pipes[pipeID].sourceCounts[i] = stamp.sequence;
+	}
+
+	return i;
+}
+
+void* nodeSystemWriteAcquire(int pipeID){
+	//check system state
+	if(_nodeSystemIsActive != 2){
+		return NULL;
+	}
+
+	//check pipe type
+	if((_pipes[pipeID].type != NODE_PIPE_OUT && _pipes[pipeID].type != NODE_PIPE_STREAM) || _pipes[pipeID].isLoaned)
+		return NULL;
+
+	//seqlock pipe keeps published buffer odd while loaned (readers would spin and fail)
+	if(((pipeHead*)_pipes[pipeID].shm.shmMap)->mode == PIPE_MODE_SEQLOCK){
+		debugPrintf("%s(): [%s]: write loan needs NODE_PIPE_OPT_TRIPLE or NODE_PIPE_OPT_SEMAPHORE",__func__,_pipes[pipeID].pipeName);
+		return NULL;
+	}
+
+	//borrow share memory
+	void* mem = pipeMemoryLoan(&_pipes[pipeID].shm,NODE_DATA_UNIT_SIZE[_pipes[pipeID].unit] * _pipes[pipeID].length,
+		1,&_pipes[pipeID].loan,NULL);
+	if(mem != NULL)
+		_pipes[pipeID].isLoaned = 1;
+
+	return mem;
+}
+
+int nodeSystemWriteCommit(int pipeID){
+	//check system state
+	if(_nodeSystemIsActive != 2){
+		return -1;
+	}
+
+	//check pipe type
+	if((_pipes[pipeID].type != NODE_PIPE_OUT && _pipes[pipeID].type != NODE_PIPE_STREAM) || !_pipes[pipeID].isLoaned)
+		return -1;
+
+	//publish and increment write counter
+	_pipes[pipeID].isLoaned = 0;
+	return pipeMemoryReturn(&_pipes[pipeID].shm,NODE_DATA_UNIT_SIZE[_pipes[pipeID].unit] * _pipes[pipeID].length,
+		1,_pipes[pipeID].loan);
+}
+
+const void* nodeSystemReadAcquire(int pipeID,int* isUpdated){
+	//check system state
+	if(_nodeSystemIsActive != 2){
+		return NULL;
+	}
+	
+	//check pipe type
+	if((_pipes[pipeID].shm.shmMap == NULL) || _pipes[pipeID].type == NODE_PIPE_OUT || _pipes[pipeID].type == NODE_PIPE_STREAM || _pipes[pipeID].isLoaned)
+		return NULL;
+
+	//borrow share memory
+	const void* mem = pipeMemoryLoan(&_pipes[pipeID].shm,NODE_DATA_UNIT_SIZE[_pipes[pipeID].unit] * _pipes[pipeID].length,
+		0,&_pipes[pipeID].loan,&_pipes[pipeID].loanStamp);
+	if(mem == NULL)
+		return NULL;
+
+	_pipes[pipeID].isLoaned = 1;
+	if(isUpdated)
+		*isUpdated = _pipes[pipeID].loanStamp.sequence != _pipes[pipeID].count;
+
+	return mem;
+}
+
+int nodeSystemReadRelease(int pipeID){
+	//check system state
+	if(_nodeSystemIsActive != 2){
+		return -1;
+	}
+
+	//check loan
+	if((_pipes[pipeID].shm.shmMap == NULL) || !_pipes[pipeID].isLoaned)
+		return -1;
+
+	//check writer did not overwrite borrowed data
+	_pipes[pipeID].isLoaned = 0;
+	if(pipeMemoryReturn(&_pipes[pipeID].shm,NODE_DATA_UNIT_SIZE[_pipes[pipeID].unit] * _pipes[pipeID].length,
+		0,_pipes[pipeID].loan) != 0)
+		return -1;
+
+	//update read count
+	pipeMetricRead(&_pipes[pipeID].shm,NODE_DATA_UNIT_SIZE[_pipes[pipeID].unit] * _pipes[pipeID].length,_pipes[pipeID].count,_pipes[pipeID].loanStamp.sequence);
+	_pipes[pipeID].count = _pipes[pipeID].loanStamp.sequence;
+	return 0;
+}
+
+int nodeSystemWait(){
+	//check system state
+	if(_nodeSystemIsActive != 2){
+		return -1;
+	}
+
+	//report completion so timer can wake next level
+	if(_wakeupKey.shmMap != NULL && _slot >= 0){
+		wakeupTable* table = _wakeupKey.shmMap;
+		wakeupSlot* slot = &table->nodes[_slot];
+
+		//worst completion after deadline
+		struct timespec spec;
+		clock_gettime(CLOCK_MONOTONIC,&spec);
+		uint64_t now = spec.tv_sec * 1000000000ULL + spec.tv_nsec;
+		uint64_t deadline = __atomic_load_n(&slot->deadline,__ATOMIC_RELAXED);
+		if(deadline != 0 && now > deadline && now - deadline > slot->lateMax)
+			__atomic_store_n(&slot->lateMax,now - deadline,__ATOMIC_RELAXED);
+
+		//wake to nodeSystemWait
+		if(_resumeTime != 0){
+			uint64_t exec = now - _resumeTime;
+			slot->execHist[histIndex(exec)]++;
+			if(exec > slot->execMax)
+				slot->execMax = exec;
+		}
+
+		__atomic_store_n(&slot->done,__atomic_load_n(&slot->wake,__ATOMIC_ACQUIRE),__ATOMIC_RELEASE);
+		__atomic_add_fetch(&table->doneCount,1,__ATOMIC_SEQ_CST);
+		if(__atomic_load_n(&table->waiting,__ATOMIC_SEQ_CST))
+			syscall(SYS_futex,&table->doneCount,FUTEX_WAKE,1,NULL,NULL,0);
+	}
+
+	kill(_self,SIGTSTP);
+
+	//SIGCONT to resume (only when woken by timer)
+	if(_wakeupKey.shmMap != NULL && _slot >= 0){
+		wakeupSlot* slot = &((wakeupTable*)_wakeupKey.shmMap)->nodes[_slot];
+
+		struct timespec spec;
+		clock_gettime(CLOCK_MONOTONIC,&spec);
+		_resumeTime = spec.tv_sec * 1000000000ULL + spec.tv_nsec;
+		if(__atomic_load_n(&slot->wake,__ATOMIC_ACQUIRE) != slot->done){
+			uint64_t wakeTime = __atomic_load_n(&slot->wakeTime,__ATOMIC_RELAXED);
+			uint64_t wakeup = _resumeTime > wakeTime ? _resumeTime - wakeTime : 0;
+			slot->wakeupHist[histIndex(wakeup)]++;
+			if(wakeup > slot->wakeupMax)
+				slot->wakeupMax = wakeup;
+		}
+	}
+
+	//next tick
+	tickCount++;
+
+	return 0;
+}
+
+int nodeSystemWaitInput(double timeout){
+	//check system state
+	if(_nodeSystemIsActive != 2){
+		return -1;
+	}
+
+	//absolute deadline
+	struct timespec deadline;
+	clock_gettime(CLOCK_MONOTONIC,&deadline);
+	if(timeout >= 0){
+		int64_t nsec = deadline.tv_nsec + (int64_t)(timeout * 1000000LL);
+		deadline.tv_sec += nsec / 1000000000LL;
+		deadline.tv_nsec = nsec % 1000000000LL;
+	}
+
+	//count input words
+	int count = 1;
+	uint16_t i;
+	for(i = 0;i < _pipe_count;i++){
+		if(_pipes[i].type == NODE_PIPE_MERGE)
+			count += _pipes[i].sourceCount;
+		else if(_pipes[i].type == NODE_PIPE_IN || _pipes[i].type == NODE_PIPE_CONST)
+			count++;
+	}
+
+	struct futex_waitv* waits = malloc(sizeof(struct futex_waitv)*count);
+	pipeHead** heads = malloc(sizeof(pipeHead*)*count);
+	if(!waits || !heads){
+		free(waits);
+		free(heads);
+		return -1;
+	}
+
+	int res = 0;
+	while(1){
+		//seq of input is twice its last consumed sequence
+		int n = 0;
+		for(i = 0;i < _pipe_count;i++){
+			if(_pipes[i].type == NODE_PIPE_MERGE){
+				int j;
+				for(j = 0;j < _pipes[i].sourceCount;j++){
+					heads[n] = _pipes[i].sources[j].shmMap;
+					waits[n++].val = (uint32_t)(_pipes[i].sourceCounts[j] * 2);
+				}
+			}else if((_pipes[i].type == NODE_PIPE_IN || _pipes[i].type == NODE_PIPE_CONST) && _pipes[i].shm.shmMap != NULL){
+				heads[n] = _pipes[i].shm.shmMap;
+				uint64_t consumed = _pipes[i].count > _pipes[i].cursor ? _pipes[i].count : _pipes[i].cursor;
+				waits[n++].val = (uint32_t)(consumed * 2);
+			}
+		}
+
+		//unread input
+		int k;
+		for(k = 0;k < n;k++){
+			if(__atomic_load_n(&heads[k]->seq,__ATOMIC_ACQUIRE) != (uint32_t)waits[k].val){
+				res = 1;
+				break;
+			}
+		}
+		if(res)
+			break;
+
+		//control message or timeout
+		nodeSystemEnv* env = systemSettingKey.shmMap;
+		if(__atomic_load_n(&env->event,__ATOMIC_ACQUIRE) != _eventCount)
+			break;
+
+		struct timespec now;
+		clock_gettime(CLOCK_MONOTONIC,&now);
+		if(timeout >= 0 && (now.tv_sec > deadline.tv_sec || (now.tv_sec == deadline.tv_sec && now.tv_nsec >= deadline.tv_nsec)))
+			break;
+
+		//register as waiter and sleep
+		for(k = 0;k < n;k++){
+			__atomic_add_fetch(&heads[k]->waiters,1,__ATOMIC_SEQ_CST);
+			waits[k].uaddr = (uintptr_t)&heads[k]->seq;
+			waits[k].flags = FUTEX_32;
+			waits[k].__reserved = 0;
+		}
+		waits[n].val = _eventCount;
+		waits[n].uaddr = (uintptr_t)&env->event;
+		waits[n].flags = FUTEX_32;
+		waits[n].__reserved = 0;
+
+		int ret = futexWait(waits,n + 1,timeout >= 0 ? &deadline : NULL);
+
+		for(k = 0;k < n;k++){
+			__atomic_sub_fetch(&heads[k]->waiters,1,__ATOMIC_RELAXED);
+		}
+
+		if(ret != 0){
+			res = -1;
+			break;
+		}
+	}
+
+	free(waits);
+	free(heads);
+
+	return res;
+}
+
+double nodeSystemGetPeriod(){
+	//own period is base period times divisor
+	if(_wakeupKey.shmMap != NULL && _slot >= 0)
+		return systemSettingMemory->period * __atomic_load_n(&((wakeupTable*)_wakeupKey.shmMap)->nodes[_slot].divisor,__ATOMIC_RELAXED);
+
+	return systemSettingMemory->period;
+}
+
+static void pipeMetricRead(shm_key* shm,size_t bytes,uint64_t last,uint64_t sequence){
+	//shared by every reader of the pipe
+	pipeReadMetric* metric = PIPE_READ_METRIC(shm->shmMap);
+	__atomic_add_fetch(&metric->reads,1,__ATOMIC_RELAXED);
+	__atomic_add_fetch(&metric->bytes,bytes,__ATOMIC_RELAXED);
+	if(sequence == last)
+		__atomic_add_fetch(&metric->unchanged,1,__ATOMIC_RELAXED);
+	else if(last != 0 && sequence > last + 1)
+		__atomic_add_fetch(&metric->skipped,sequence - last - 1,__ATOMIC_RELAXED);
+}
+
+static int pipeStreamRead(shm_key* shm,void* buf,size_t size,uint16_t maxCount,uint64_t* cursor,uint64_t* lost){
+	//check argment
+	if(!shm || !shm->shmMap || !cursor || !lost){
+		debugPrintf("%s(): invalid argment",__func__);
+		return -1;
+	}
+
+	pipeHead* head = shm->shmMap;
+	if(head->mode != PIPE_MODE_STREAM){
+		debugPrintf("%s(): pipe is not stream",__func__);
+		return -1;
+	}
+
+	uint64_t index = __atomic_load_n(&head->index,__ATOMIC_ACQUIRE);
+	
+	//skip overwritten elements
+	if(index - *cursor > head->depth){
+		*lost += index - *cursor - head->depth;
+		*cursor = index - head->depth;
+	}
+
+	int count = 0;
+	while(*cursor < index && count < maxCount){
+		pipeSlot* slot = PIPE_SLOT(head,size,*cursor % head->depth);
+		uint64_t begin = __atomic_load_n(&slot->seq,__ATOMIC_ACQUIRE);
+
+		//copy
+		memcpy(buf + size*count,slot + 1,size);
+
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		uint64_t end = __atomic_load_n(&slot->seq,__ATOMIC_RELAXED);
+
+		//writer lapped this slot
+		if(begin != *cursor*2 + 2 || begin != end){
+			(*lost)++;
+		}else{
+			count++;
+		}
+		(*cursor)++;
 	}
 
-	//change mode
-	_dMode = mode;
+	return count;
+}
 
-	return 0;
+static int shareMemoryRecvKey(int fd,shm_key* shm){
+	uint64_t size;
+	fileRead(fd,&shm->backend,sizeof(shm->backend));
+	fileRead(fd,&shm->semId,sizeof(shm->semId));
+	fileRead(fd,&shm->shmId,sizeof(shm->shmId));
+	fileRead(fd,&shm->ownerPid,sizeof(shm->ownerPid));
+	fileRead(fd,&shm->memFd,sizeof(shm->memFd));
+	fileRead(fd,&shm->offset,sizeof(shm->offset));
+	int res = fileRead(fd,&size,sizeof(size));
+	shm->size = size;
+	return res;
 }
 
-int nodeSystemRead(int pipeID,void* buffer){
-	//check system state
-	if(_nodeSystemIsActive != 2){
-		return -1;
-	}
-	
-	//check pipe type
-	if((_pipes[pipeID].shm.shmMap == NULL) || _pipes[pipeID].type == NODE_PIPE_OUT)
-		return -1;
-	
-	shareMemoryLock(&_pipes[pipeID].shm);
+static int fileRead(int fd,void* buf,ssize_t size){
+	ssize_t readCount;
+	ssize_t readSize = 0;
 	
-	//read count
-	uint8_t count = ((char*)_pipes[pipeID].shm.shmMap)[0];
-
-	//copy data
-	memcpy(buffer,_pipes[pipeID].shm.shmMap+1,NODE_DATA_UNIT_SIZE[_pipes[pipeID].unit] * _pipes[pipeID].length);
+	do{
+		readCount = read(fd,buf + readSize,size - readSize);
+		if(readCount > 0)
+			readSize += readCount;
+		else if(readCount == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR))
+			return -1;
+		else if(fileWait(fd,POLLIN,NULL) < 0)
+			return -1;
 	
-	shareMemoryUnLock(&_pipes[pipeID].shm);
-
-	if(count == _pipes[pipeID].count)
-			return 0;
+	}while(readSize != size);
 
-	_pipes[pipeID].count = count;
-	return 1;
+	return size;
 }
 
-int nodeSystemWrite(int pipeID,void* const buffer){
-	//check system state
-	if(_nodeSystemIsActive != 2){
+static int futexWait(struct futex_waitv* waits,int count,const struct timespec* deadline){
+	//check argment
+	if(!waits || count <= 0){
+		debugPrintf("%s(): invalid argment",__func__);
 		return -1;
 	}
-	
-	//check pipe type
-	if(_pipes[pipeID].type != NODE_PIPE_OUT)
-		return -1;
-
-	shareMemoryLock(&_pipes[pipeID].shm);
 
-	//write count
-	((uint8_t*)_pipes[pipeID].shm.shmMap)[0] = ++_pipes[pipeID].count;
+	//sleep on all words at once
+	if(count <= FUTEX_WAITV_MAX){
+		if(syscall(SYS_futex_waitv,waits,count,0,deadline,CLOCK_MONOTONIC) >= 0)
+			return 0;
+		if(errno == ETIMEDOUT || errno == EAGAIN || errno == EINTR)
+			return 0;
+		if(errno != ENOSYS){
+			debugPrintf("%s(): futex_waitv(): %s",__func__,strerror(errno));
+			return -1;
+		}
+	}
 
-	//copy data
-	memcpy(_pipes[pipeID].shm.shmMap+1,buffer,NODE_DATA_UNIT_SIZE[_pipes[pipeID].unit] * _pipes[pipeID].length);
+	//old kernel: sleep on first word and recheck the others every slice
+	struct timespec now,slice = {.tv_sec = 0,.tv_nsec = PIPE_WAIT_SLICE};
+	if(deadline){
+		clock_gettime(CLOCK_MONOTONIC,&now);
+		int64_t rest = (deadline->tv_sec - now.tv_sec) * 1000000000LL + (deadline->tv_nsec - now.tv_nsec);
+		if(rest <= 0)
+			return 0;
+		if(count == 1 || rest < PIPE_WAIT_SLICE){
+			slice.tv_sec = rest / 1000000000LL;
+			slice.tv_nsec = rest % 1000000000LL;
+		}
+	}
 
-	shareMemoryUnLock(&_pipes[pipeID].shm);
+	const struct timespec* timeout = (count == 1 && !deadline) ? NULL : &slice;
+	if(syscall(SYS_futex,(uint32_t*)(uintptr_t)waits[0].uaddr,FUTEX_WAIT,(uint32_t)waits[0].val,timeout,NULL,0) < 0){
+		if(errno != ETIMEDOUT && errno != EAGAIN && errno != EINTR){
+			debugPrintf("%s(): futex(): %s",__func__,strerror(errno));
+			return -1;
+		}
+	}
 
 	return 0;
 }
 
-int nodeSystemWait(){
-	//check system state
-	if(_nodeSystemIsActive != 2){
-		return -1;
-	}
-
-	kill(_self,SIGTSTP);
+static int histIndex(uint64_t value){
+	//exact below 2^HIST_SUB_BITS, then top HIST_SUB_BITS bits under leading one
+	if(value < (1 << HIST_SUB_BITS))
+		return value;
+	int exp = 63 - __builtin_clzll(value);
+	int index = ((exp - HIST_SUB_BITS + 1) << HIST_SUB_BITS) + ((value >> (exp - HIST_SUB_BITS)) & ((1 << HIST_SUB_BITS) - 1));
+	return index < HIST_BUCKETS ? index : HIST_BUCKETS - 1;
 }
 
-double nodeSystemGetPeriod(){
-	return systemSettingMemory->period;
+static int fileReadStr(int fd,char* str,ssize_t size){
+	ssize_t readSize = 0;
+
+	do{
+		ssize_t res = read(fd,&str[readSize],1);
+		if(res == 1)
+			readSize ++;
+		else if(res == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR))
+			return -1;
+		else if(fileWait(fd,POLLIN,NULL) < 0)
+			return -1;
+	}while((readSize == 0 || str[readSize-1] != '\0') && readSize != size);
+
+	return readSize;
 }
 
 #endif
@@ -2341,75 +5671,63 @@ static int debugPrintf(const char* fmt,...){
 	return res;
 }
 
-static int fileRead(int fd,void* buf,ssize_t size){
-	ssize_t readCount;
-	ssize_t readSize = 0;
-	
-	do{
-		readCount = read(fd,buf + readSize,size - readSize);
-		if(readCount > 0)
-			readSize += readCount;
-		else if(readCount == -1 && errno != EAGAIN && errno != EWOULDBLOCK)
-			return -1;
-	
-	}while(readSize != size);
-
-	return size;
-}
-
-static int fileReadStr(int fd,char* str,ssize_t size){
-	ssize_t readSize = 0;
-
-	do{
-		ssize_t res = read(fd,&str[readSize],1);
-		if(res == 1)
-			readSize ++;
-		else if(res == -1 && errno != EAGAIN && errno != EWOULDBLOCK)
-			return -1;
-	}while((readSize == 0 || str[readSize-1] != '\0') && readSize != size);
-
-}
-
 static int fileReadWithTimeOut(int fd,void* buf,ssize_t size,uint32_t usec){
 	ssize_t readCount;
 	ssize_t readSize = 0;
- 	struct timespec target,spec;
+	struct timespec limit;
 
-    clock_gettime(CLOCK_REALTIME, &target);
-    target.tv_nsec += 1000LL * usec;
-	target.tv_sec += target.tv_nsec / 1000000000LL;
-	target.tv_nsec %= 1000000000LL;
-	
+	//deadline on monotonic clock (wall clock may jump)
+	clock_gettime(CLOCK_MONOTONIC,&limit);
+	limit.tv_nsec += 1000LL * usec;
+	limit.tv_sec += limit.tv_nsec / 1000000000LL;
+	limit.tv_nsec %= 1000000000LL;
 
 	do{
-    	clock_gettime(CLOCK_REALTIME, &spec);
 		readCount = read(fd,buf + readSize,size - readSize);
 		if(readCount > 0)
 			readSize += readCount;
-		else if(readCount == -1 && errno != EAGAIN && errno != EWOULDBLOCK)
+		else if(readCount == 0)
+			break;
+		else if(errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
 			return -1;
-	}while(readSize != size && !(target.tv_sec <= spec.tv_sec && target.tv_nsec <= spec.tv_nsec));
+		else{
+			int res = fileWait(fd,POLLIN,&limit);
+			if(res < 0)
+				return -1;
+			if(res == 0)
+				break;
+		}
+	}while(readSize != size);
 
 	return readSize;
 }
 
 static int fileReadStrWithTimeOut(int fd,char* str,ssize_t size,uint32_t usec){
 	ssize_t readSize = 0;
- 	struct timespec target,spec;
+	struct timespec limit;
+
+	//deadline on monotonic clock (wall clock may jump)
+	clock_gettime(CLOCK_MONOTONIC,&limit);
+	limit.tv_nsec += 1000LL * usec;
+	limit.tv_sec += limit.tv_nsec / 1000000000LL;
+	limit.tv_nsec %= 1000000000LL;
 
-    clock_gettime(CLOCK_REALTIME, &target);
-    target.tv_nsec += 1000LL * usec;
-	target.tv_sec += target.tv_nsec / 1000000000LL;
-	target.tv_nsec %= 1000000000LL;
-	
 	do{
-    	clock_gettime(CLOCK_REALTIME, &spec);
 		ssize_t res = read(fd,&str[readSize],1);
 		if(res == 1)
 			readSize ++;
-		else if(res == -1 && errno != EAGAIN && errno != EWOULDBLOCK)
+		else if(res == 0)
+			break;
+		else if(errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
 			return -1;
-	}while((readSize == 0 || str[readSize-1] != '\0') && readSize != size && !(target.tv_sec < spec.tv_sec && target.tv_nsec < spec.tv_nsec));
+		else{
+			int ready = fileWait(fd,POLLIN,&limit);
+			if(ready < 0)
+				return -1;
+			if(ready == 0)
+				break;
+		}
+	}while((readSize == 0 || str[readSize-1] != '\0') && readSize != size);
 
 	return readSize;
 }
@@ -2422,7 +5740,9 @@ static int fileWrite(int fd,const void* buf,ssize_t size){
 		writeCount = write(fd,buf + writeSize,size - writeSize);
 		if(writeCount > 0)
 			writeSize += writeCount;
-		else if(writeCount == -1 && errno != EAGAIN && errno != EWOULDBLOCK)
+		else if(writeCount == -1 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+			return -1;
+		else if(writeCount == -1 && fileWait(fd,POLLOUT,NULL) < 0)
 			return -1;
 	
 	}while(writeSize != size);
@@ -2430,6 +5750,32 @@ static int fileWrite(int fd,const void* buf,ssize_t size){
 	return size;
 }
 
+static int fileWait(int fd,short events,const struct timespec* limit){
+	//sleep until fd is ready (0: CLOCK_MONOTONIC limit is passed)
+	struct timespec rest,*timeout = NULL;
+	if(limit){
+		struct timespec now;
+		clock_gettime(CLOCK_MONOTONIC,&now);
+		int64_t ns = (limit->tv_sec - now.tv_sec) * 1000000000LL + (limit->tv_nsec - now.tv_nsec);
+		if(ns <= 0)
+			return 0;
+		rest.tv_sec = ns / 1000000000LL;
+		rest.tv_nsec = ns % 1000000000LL;
+		timeout = &rest;
+	}
+
+	struct pollfd pfd = {.fd = fd,.events = events};
+	int res = ppoll(&pfd,1,timeout,NULL);
+	if(res < 0){
+		if(errno == EINTR)
+			return 1;
+		debugPrintf("%s(): ppoll(): %s",__func__,strerror(errno));
+		return -1;
+	}
+
+	return res;
+}
+
 static int fileWriteStr(int fd,const char* str){
 	size_t len = strlen(str)+1;
 	return fileWrite(fd,str,len);
@@ -2442,7 +5788,59 @@ static int shareMemoryGenerate(size_t size,shm_key* shm){
 		return -1;
 	}
 
+	//select backend
+	uint8_t backend = systemSettingMemory ? systemSettingMemory->shmBackend : NODE_SHM_SYSV;
+	memset(shm,0,sizeof(*shm));
+
+	if(backend != NODE_SHM_SYSV){
+		shm->backend = NODE_SHM_MEMFD;
+		shm->ownerPid = getpid();
+		shm->size = size + SHM_PREFIX_SIZE;
+
+		//try huge page for large memory
+		shm->memFd = -1;
+		if(backend == NODE_SHM_MEMFD_HUGE && shm->size >= SHM_HUGE_PAGE_SIZE){
+			size_t normalSize = shm->size;
+			shm->size = (shm->size + SHM_HUGE_PAGE_SIZE - 1) & ~(size_t)(SHM_HUGE_PAGE_SIZE - 1);
+			shm->memFd = memfd_create("nodeSystem",MFD_CLOEXEC | MFD_HUGETLB);
+
+			//fall back if huge page is not reserved
+			if(shm->memFd >= 0 && (ftruncate(shm->memFd,shm->size) != 0 || shareMemoryOpen(shm,0) != 0)){
+				close(shm->memFd);
+				shm->memFd = -1;
+			}
+			if(shm->memFd < 0)
+				shm->size = normalSize;
+		}
+
+		//generate memfd
+		if(shm->memFd < 0){
+			shm->memFd = memfd_create("nodeSystem",MFD_CLOEXEC);
+			if(shm->memFd < 0){
+				debugPrintf("%s(): memfd_create(): %s",__func__,strerror(errno));
+				return -1;
+			}
+			if(ftruncate(shm->memFd,shm->size) != 0 || shareMemoryOpen(shm,0) != 0){
+				debugPrintf("%s(): ftruncate(): %s",__func__,strerror(errno));
+				close(shm->memFd);
+				return -1;
+			}
+		}
+
+		//init semaphore in prefix
+		if(sem_init(shm->shmMap - SHM_PREFIX_SIZE,1,1) != 0){
+			debugPrintf("%s(): sem_init(): %s",__func__,strerror(errno));
+			shareMemoryClose(shm);
+			close(shm->memFd);
+			return -1;
+		}
+		shareMemoryClose(shm);
+
+		return 0;
+	}
+
 	//generate shm
+	shm->size = size;
 	shm->shmId = shmget(IPC_PRIVATE, size,0666);
 	if(shm->shmId < 0){
 		debugPrintf("%s(): shmget(): %s",__func__,strerror(errno));
@@ -2478,6 +5876,21 @@ static int shareMemoryDeleate(shm_key* shm){
 	if(shm->shmMap)
 		shareMemoryClose(shm);
 
+	//arena block is released by owner of arena
+	if(shm->backend == SHM_ARENA){
+		debugPrintf("%s(): memory is part of pipe arena",__func__);
+		return -1;
+	}
+
+	//memfd is released with last mapping
+	if(shm->backend == NODE_SHM_MEMFD){
+		if(close(shm->memFd) != 0){
+			debugPrintf("%s(): close(): %s",__func__,strerror(errno));
+			return -1;
+		}
+		return 0;
+	}
+
 	//deleate shm
 	if(shmctl(shm->shmId,IPC_RMID,NULL) != 0){
 		debugPrintf("%s(): shmctl(): %s",__func__,strerror(errno));
@@ -2500,9 +5913,51 @@ static int shareMemoryOpen(shm_key* shm,int shmFlag){
 		return -1;
 	}
 
+	if(shm->backend == SHM_ARENA){
+		//pipe arena is already mapped
+		if(pipeArena.shmMap == NULL){
+			shm->shmMap = NULL;
+			debugPrintf("%s(): pipe arena is not mapped",__func__);
+			return -1;
+		}
+
+		shm->shmMap = pipeArena.shmMap + shm->offset + SHM_PREFIX_SIZE;
+		return 0;
+	}else if(shm->backend == NODE_SHM_MEMFD){
+		//open memfd of owner process
+		int memFd = shm->memFd;
+		if(shm->ownerPid != getpid()){
+			char path[64];
+			sprintf(path,"/proc/%d/fd/%d",shm->ownerPid,shm->memFd);
+			memFd = open(path,O_RDWR | O_CLOEXEC);
+			if(memFd < 0){
+				shm->shmMap = NULL;
+				debugPrintf("%s(): open(): %s",__func__,strerror(errno));
+				return -1;
+			}
+		}
+
+		//semaphore in prefix is written by reader too
+		void* map = mmap(NULL,shm->size,PROT_READ | PROT_WRITE,MAP_SHARED,memFd,0);
+		if(memFd != shm->memFd)
+			close(memFd);
+		if(map == MAP_FAILED){
+			shm->shmMap = NULL;
+			debugPrintf("%s(): mmap(): %s",__func__,strerror(errno));
+			return -1;
+		}
+
+		//transparent huge page for large memory
+		if(shm->size >= SHM_HUGE_PAGE_SIZE)
+			madvise(map,shm->size,MADV_HUGEPAGE);
+
+		shm->shmMap = map + SHM_PREFIX_SIZE;
+		return 0;
+	}
+
 	//generate shm
 	shm->shmMap = shmat(shm->shmId,NULL,shmFlag);
-	if(shm->shmMap < 0){
+	if(shm->shmMap == (void*)-1){
 		shm->shmMap = NULL;
 		debugPrintf("%s(): shmat(): %s",__func__,strerror(errno));
 		return -1;
@@ -2518,8 +5973,14 @@ static int shareMemoryClose(shm_key* shm){
 		return -1;
 	}
 
-	//generate shm
-	if(shmdt(shm->shmMap) != 0){
+	if(shm->backend == SHM_ARENA){
+		//keep pipe arena mapped
+	}else if(shm->backend == NODE_SHM_MEMFD){
+		if(munmap(shm->shmMap - SHM_PREFIX_SIZE,shm->size) != 0){
+			debugPrintf("%s(): munmap(): %p %s",__func__,shm->shmMap,strerror(errno));
+			return -1;
+		}
+	}else if(shmdt(shm->shmMap) != 0){
 		debugPrintf("%s(): shmdt(): %p %s",__func__,shm->shmMap,strerror(errno));
 		return -1;
 	}
@@ -2590,7 +6051,14 @@ static int shareMemoryLock(shm_key* shm)
 		return -1;
 	}
 
-	if(semop(shm->semId,&op,1) == -1) {
+	if(shm->backend == NODE_SHM_MEMFD || shm->backend == SHM_ARENA){
+		while(sem_wait(shm->shmMap - SHM_PREFIX_SIZE) == -1){
+			if(errno != EINTR){
+				debugPrintf("%s(): sem_wait(): %s",__func__,strerror(errno));
+				return -1;
+			}
+		}
+	}else if(semop(shm->semId,&op,1) == -1) {
 		debugPrintf("%s(): semop(): %s",__func__,strerror(errno));
 		return -1;
 	}
@@ -2608,10 +6076,270 @@ static int shareMemoryUnLock(shm_key* shm)
 		return -1;
 	}
 
-	if(semop(shm->semId,&op,1) == -1) {
+	if(shm->backend == NODE_SHM_MEMFD || shm->backend == SHM_ARENA){
+		if(sem_post(shm->shmMap - SHM_PREFIX_SIZE) == -1){
+			debugPrintf("%s(): sem_post(): %s",__func__,strerror(errno));
+			return -1;
+		}
+	}else if(semop(shm->semId,&op,1) == -1) {
 		debugPrintf("%s(): semop(): %s",__func__,strerror(errno));
 		return -1;
 	}
 
 	return 0;
-}
\ No newline at end of file
+}
+
+static int pipeMemoryRead(shm_key* shm,void* buf,size_t size,pipeStamp* stamp){
+	uint64_t loan;
+	int res;
+
+	do{
+		//borrow
+		void* mem = pipeMemoryLoan(shm,size,0,&loan,stamp);
+		if(mem == NULL)
+			return -1;
+
+		//copy
+		memcpy(buf,mem,size);
+
+		//retry if writer was in progress
+		res = pipeMemoryReturn(shm,size,0,loan);
+	}while(res == 1);
+
+	return res;
+}
+
+static int pipeMemoryWrite(shm_key* shm,const void* buf,size_t size){
+	uint64_t loan;
+
+	//borrow
+	void* mem = pipeMemoryLoan(shm,size,1,&loan,NULL);
+	if(mem == NULL)
+		return -1;
+
+	//copy
+	memcpy(mem,buf,size);
+
+	return pipeMemoryReturn(shm,size,1,loan);
+}
+
+static void* pipeMemoryLoan(shm_key* shm,size_t size,uint8_t isWrite,uint64_t* seq,pipeStamp* stamp){
+	//check argment
+	if(!shm || !shm->shmMap || !seq){
+		debugPrintf("%s(): invalid argment",__func__);
+		return NULL;
+	}
+
+	pipeHead* head = shm->shmMap;
+
+	if(head->mode == PIPE_MODE_SEMAPHORE){
+		//lock until return
+		struct timespec begin,end;
+		clock_gettime(CLOCK_MONOTONIC,&begin);
+		if(shareMemoryLock(shm) != 0){
+			debugPrintf("%s(): shareMemoryLock() is failed",__func__);
+			return NULL;
+		}
+		clock_gettime(CLOCK_MONOTONIC,&end);
+
+		//lock wait (metric is guarded by the lock)
+		pipeWriteMetric* metric = PIPE_WRITE_METRIC(head);
+		uint64_t wait = (end.tv_sec - begin.tv_sec) * 1000000000ULL + end.tv_nsec - begin.tv_nsec;
+		metric->lockCount++;
+		metric->lockWaitSum += wait;
+		if(wait > metric->lockWaitMax)
+			metric->lockWaitMax = wait;
+
+		*seq = head->seq;
+		if(stamp)
+			*stamp = head->stamp;
+
+		return PIPE_DATA(head);
+	}
+
+	if(isWrite){
+		if(head->mode == PIPE_MODE_STREAM){
+			//odd slot sequence while writing next slot (single producer)
+			uint64_t index = __atomic_load_n(&head->index,__ATOMIC_RELAXED);
+			pipeSlot* slot = PIPE_SLOT(head,size,index % head->depth);
+			__atomic_store_n(&slot->seq,index*2 + 1,__ATOMIC_RELAXED);
+			__atomic_thread_fence(__ATOMIC_RELEASE);
+
+			*seq = index;
+			return slot + 1;
+		}else if(head->mode == PIPE_MODE_TRIPLE){
+			//write back buffer which no reader can get as latest
+			uint32_t begin = __atomic_load_n(&head->seq,__ATOMIC_RELAXED);
+			pipeSlot* slot = PIPE_SLOT(head,size,head->back);
+			__atomic_store_n(&slot->seq,(uint64_t)begin + 1,__ATOMIC_RELAXED);
+			__atomic_thread_fence(__ATOMIC_RELEASE);
+
+			*seq = ((uint64_t)begin << 2) | head->back;
+			return slot + 1;
+		}else{
+			//odd sequence while writing (single writer)
+			uint32_t begin = __atomic_load_n(&head->seq,__ATOMIC_RELAXED);
+			__atomic_store_n(&head->seq,begin + 1,__ATOMIC_RELAXED);
+			__atomic_thread_fence(__ATOMIC_RELEASE);
+
+			*seq = begin;
+			return PIPE_DATA(head);
+		}
+	}
+
+	//wait until writer is finished
+	uint32_t retry = 0;
+	while(1){
+		if(retry++ > PIPE_READ_RETRY){
+			debugPrintf("%s(): writer is not finished",__func__);
+			return NULL;
+		}else if(retry > PIPE_READ_SPIN){
+			sched_yield();
+		}
+
+		if(head->mode == PIPE_MODE_STREAM){
+			//newest slot is stable when its sequence matches write index
+			uint64_t index = __atomic_load_n(&head->index,__ATOMIC_ACQUIRE);
+			pipeSlot* slot = PIPE_SLOT(head,size,(index ? index - 1 : 0) % head->depth);
+			uint64_t begin = __atomic_load_n(&slot->seq,__ATOMIC_ACQUIRE);
+			if(begin != index*2)
+				continue;
+
+			*seq = begin;
+			if(stamp)
+				*stamp = slot->stamp;
+
+			return slot + 1;
+		}else if(head->mode == PIPE_MODE_TRIPLE){
+			//latest complete buffer
+			uint32_t latest = __atomic_load_n(&head->latest,__ATOMIC_ACQUIRE);
+			pipeSlot* slot = PIPE_SLOT(head,size,latest);
+			uint64_t begin = __atomic_load_n(&slot->seq,__ATOMIC_ACQUIRE);
+			if(begin & 1)
+				continue;
+
+			*seq = (begin << 2) | latest;
+			if(stamp)
+				*stamp = slot->stamp;
+
+			return slot + 1;
+		}else{
+			uint32_t begin = __atomic_load_n(&head->seq,__ATOMIC_ACQUIRE);
+			if(begin & 1)
+				continue;
+
+			*seq = begin;
+			if(stamp)
+				*stamp = head->stamp;
+
+			return PIPE_DATA(head);
+		}
+	}
+}
+
+static int pipeMemoryReturn(shm_key* shm,size_t size,uint8_t isWrite,uint64_t seq){
+	//check argment
+	if(!shm || !shm->shmMap){
+		debugPrintf("%s(): invalid argment",__func__);
+		return -1;
+	}
+
+	pipeHead* head = shm->shmMap;
+
+	//stamp of this write
+	pipeStamp stamp = {};
+	if(isWrite){
+		struct timespec spec;
+		clock_gettime(CLOCK_MONOTONIC,&spec);
+		stamp.sequence = ++head->sequence;
+		stamp.timestamp = spec.tv_sec * 1000000000ULL + spec.tv_nsec;
+		stamp.tick = tickCount;
+
+		//single writer
+		pipeWriteMetric* metric = PIPE_WRITE_METRIC(head);
+		__atomic_store_n(&metric->writes,metric->writes + 1,__ATOMIC_RELAXED);
+		__atomic_store_n(&metric->bytes,metric->bytes + size,__ATOMIC_RELAXED);
+	}
+
+	if(head->mode == PIPE_MODE_SEMAPHORE){
+		//increment write counter
+		if(isWrite){
+			head->seq += 2;
+			head->stamp = stamp;
+		}
+
+		//unlock
+		if(shareMemoryUnLock(shm) != 0){
+			debugPrintf("%s(): shareMemoryUnLock() is failed",__func__);
+			return -1;
+		}
+
+		//wake readers
+		if(isWrite)
+			return pipeMemoryWake(head);
+
+		return 0;
+	}
+
+	if(isWrite){
+		if(head->mode == PIPE_MODE_STREAM){
+			//publish slot
+			pipeSlot* slot = PIPE_SLOT(head,size,seq % head->depth);
+			slot->stamp = stamp;
+			__atomic_store_n(&slot->seq,seq*2 + 2,__ATOMIC_RELEASE);
+			__atomic_store_n(&head->index,seq + 1,__ATOMIC_RELEASE);
+			__atomic_store_n(&head->seq,(uint32_t)(seq + 1) * 2,__ATOMIC_RELEASE);
+		}else if(head->mode == PIPE_MODE_TRIPLE){
+			//publish back buffer and write the oldest one next
+			uint8_t back = seq & 3;
+			pipeSlot* slot = PIPE_SLOT(head,size,back);
+			slot->stamp = stamp;
+			__atomic_store_n(&slot->seq,(seq >> 2) + 2,__ATOMIC_RELEASE);
+			uint32_t old = __atomic_exchange_n(&head->latest,back,__ATOMIC_ACQ_REL);
+			head->back = 3 - back - old;
+			__atomic_store_n(&head->seq,(uint32_t)(seq >> 2) + 2,__ATOMIC_RELEASE);
+		}else{
+			head->stamp = stamp;
+			__atomic_store_n(&head->seq,(uint32_t)seq + 2,__ATOMIC_RELEASE);
+		}
+
+		//wake readers
+		return pipeMemoryWake(head);
+	}
+
+	//check that writer did not touch borrowed memory
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	if(head->mode == PIPE_MODE_STREAM){
+		uint64_t index = seq / 2;
+		pipeSlot* slot = PIPE_SLOT(head,size,(index ? index - 1 : 0) % head->depth);
+		return __atomic_load_n(&slot->seq,__ATOMIC_RELAXED) != seq;
+	}else if(head->mode == PIPE_MODE_TRIPLE){
+		pipeSlot* slot = PIPE_SLOT(head,size,seq & 3);
+		return __atomic_load_n(&slot->seq,__ATOMIC_RELAXED) != (seq >> 2);
+	}else{
+		return __atomic_load_n(&head->seq,__ATOMIC_RELAXED) != seq;
+	}
+}
+
+static int pipeMemoryWake(pipeHead* head){
+	//check argment
+	if(!head){
+		debugPrintf("%s(): invalid argment",__func__);
+		return -1;
+	}
+
+	//order seq store before waiters load (reader does the reverse)
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+	//no syscall while nobody sleeps
+	if(__atomic_load_n(&head->waiters,__ATOMIC_RELAXED) == 0)
+		return 0;
+
+	if(syscall(SYS_futex,&head->seq,FUTEX_WAKE,INT_MAX,NULL,NULL,0) < 0){
+		debugPrintf("%s(): futex(): %s",__func__,strerror(errno));
+		return -1;
+	}
+
+	return 0;
+}
+
@@ -1,13 +1,26 @@
 #pragma once
 #include <stdint.h>
+#include <stddef.h>
 
 //Pipe type
 typedef enum{
 	NODE_PIPE_IN	= 0,
 	NODE_PIPE_OUT	= 1,
-	NODE_PIPE_CONST	= 2
+	NODE_PIPE_CONST	= 2,
+	NODE_PIPE_STREAM= 3,
+	NODE_PIPE_MERGE	= 4
 } NODE_PIPE_TYPE;
 
+//Pipe option (OR with pipe type in nodeSystemAddPipe)
+typedef enum{
+	NODE_PIPE_OPT_SEMAPHORE	= 0x10,
+	NODE_PIPE_OPT_TRIPLE	= 0x20,
+	NODE_PIPE_OPT_DELAY		= 0x40	//IN/MERGE: one tick delay edge (breaks wakeup order cycle)
+} NODE_PIPE_OPTION;
+
+//Mask of pipe type
+#define NODE_PIPE_TYPE_MASK 0x0F
+
 //Pipe unit
 typedef enum{
 	NODE_UNIT_CHAR	 = 1,
@@ -30,11 +43,102 @@ typedef enum{
 	NODE_DEBUG_CSV = 1
 } NODE_DEBUG_MODE;
 
+//Pipe read info
+typedef struct{
+	uint64_t sequence;	//write sequence number (0: never written)
+	uint64_t timestamp;	//CLOCK_MONOTONIC write time [ns]
+	uint64_t tick;		//tick index of writer
+	uint64_t skipped;	//updates skipped since last read
+} NODE_PIPE_INFO;
+
+//Shared memory backend
+typedef enum{
+	NODE_SHM_SYSV		= 0,
+	NODE_SHM_MEMFD		= 1,
+	NODE_SHM_MEMFD_HUGE	= 2
+} NODE_SHM_BACKEND;
+
+//Drop policy of node stderr buffer (nodeSystemSetLogBuffer)
+typedef enum{
+	NODE_LOG_DROP_OLDEST	= 0,
+	NODE_LOG_DROP_NEWEST	= 1
+} NODE_LOG_DROP;
+
+//Handle of node or pipe (nodeSystemResolve, 0: not found)
+//becomes stale when the node is killed
+typedef uint64_t NODE_HANDLE;
+
+//Timer policy of missed ticks
+typedef enum{
+	NODE_TIMER_SKIP		= 0,
+	NODE_TIMER_CATCHUP	= 1
+} NODE_TIMER_POLICY;
+
+//Node tick statistics
+typedef struct{
+	uint64_t wakes;		//wakes by timer
+	uint64_t overruns;	//ticks fired while node was still running
+	double lateMax;		//worst completion after deadline [ms]
+	double execP50;		//wake to nodeSystemWait [ms]
+	double execP99;
+	double execMax;
+	double wakeupP50;	//SIGCONT to resume [ms]
+	double wakeupP99;
+	double wakeupMax;
+} NODE_STAT;
+
+//Pipe statistics (in pipe reports its source, counters since pipe creation)
+typedef struct{
+	uint64_t writes;
+	uint64_t writeBytes;
+	uint64_t reads;			//sum of every reader
+	uint64_t readBytes;
+	uint64_t unchanged;		//reads that saw no new write
+	uint64_t skipped;		//writes never seen by a reader
+	uint64_t lockCount;		//semaphore lock taken (NODE_PIPE_OPT_SEMAPHORE)
+	double lockWaitTotal;	//semaphore wait [ms]
+	double lockWaitMax;		//worst semaphore wait [ms]
+} NODE_PIPE_STAT;
+
+//Scheduling policy of node process
+typedef enum{
+	NODE_SCHED_OTHER	= 0,
+	NODE_SCHED_FIFO		= 1,
+	NODE_SCHED_RR		= 2,
+	NODE_SCHED_DEADLINE	= 3
+} NODE_SCHED_POLICY;
+
+//Timer statistics
+typedef struct{
+	uint64_t ticks;		//fired ticks since nodeSystemTimerRun
+	uint64_t missed;	//ticks dropped by NODE_TIMER_SKIP
+	double lateAvg;		//average lateness of tick [ms]
+	double lateMax;		//worst lateness of tick [ms]
+	double jitterAvg;	//average |tick interval - period| [ms]
+	double jitterMax;	//worst |tick interval - period| [ms]
+} NODE_TIMER_STAT;
+
 //String of pipe type
-static const char* NODE_PIPE_TYPE_STR[3] = {
+static const char* NODE_PIPE_TYPE_STR[5] = {
 	"IN",
 	"OUT",
-	"CONST"
+	"CONST",
+	"STREAM",
+	"MERGE"
+};
+
+//String of timer policy
+static const char* NODE_TIMER_POLICY_STR[2] = {
+	"SKIP",
+	"CATCHUP"
+};
+
+//String of scheduling policy (nodeSystemAddNode "-sched")
+static const char* NODE_SCHED_POLICY_STR[4] = {
+	"other",
+	"fifo",
+	"rr",
+	"deadline"
 };
 
 //String of pipe unit
@@ -78,23 +182,42 @@ static const uint16_t NODE_DATA_UNIT_SIZE[13] = {
 };
 
 #ifdef NODE_SYSTEM_HOST
+int nodeSystemSetShmBackend(NODE_SHM_BACKEND backend);
+int nodeSystemSetArenaSize(size_t size);
+int nodeSystemSetLogBuffer(size_t size,NODE_LOG_DROP policy);
 int nodeSystemInit(uint8_t isNoLog);
 int nodeSystemAddNode(char* path,char** args);
+int nodeSystemSetEnv(char* const name,char* const value);
 void nodeSystemPrintNodeList(int* argc,char** args);
 int nodeSystemConnect(char* const inNode,char* const inPipe,char* const outNode,char* const outPipe);
 int nodeSystemDisConnect(char* const inNode,char* const inPipe);
 int nodeSystemSetConst(char* const constNode,char* const constPipe,int valueCount,char** setValue);
+NODE_HANDLE nodeSystemResolve(char* const nodeName,char* const pipeName);
+int nodeSystemConnectHandle(NODE_HANDLE inPipe,NODE_HANDLE outPipe);
+int nodeSystemDisConnectHandle(NODE_HANDLE inPipe);
+int nodeSystemSetConstHandle(NODE_HANDLE constPipe,int valueCount,char** setValue);
+char** nodeSystemGetConstHandle(NODE_HANDLE constPipe,int* retCode);
+int nodeSystemLoadConst(char* const constNode,char* const constPipe,const void* data,int size);
+int nodeSystemBatchBegin();
+int nodeSystemBatchCommit(int* results,int maxCount);
 int nodeSystemSave(char* const path);
 int nodeSystemLoad(char* const path);
 void nodeSystemTimerRun();
 void nodeSystemTimerStop();
 void nodeSystemTimerSet(double period);
 void nodeSystemTimerGet();
+void nodeSystemTimerSetPolicy(NODE_TIMER_POLICY policy);
+int nodeSystemTimerSetDivisor(char* const nodeName,uint32_t divisor);
+int nodeSystemTimerSetSched(char* const cpuList,NODE_SCHED_POLICY policy,int priority);
+int nodeSystemTimerGetStat(NODE_TIMER_STAT* stat);
 int nodeSystemKill(char* const killNode);
+int nodeSystemKillHandle(NODE_HANDLE killNode);
 int nodeSystemCheck(char* const path);
 char** nodeSystemGetConst(char* const constNode,char* const constPipe,int* retCode);
 char** nodeSystemGetNodeNameList(int* counts);
+int nodeSystemGetNodeStat(char* const nodeName,NODE_STAT* stat);
 char** nodeSystemGetPipeNameList(char* nodeName,int* counts);
+int nodeSystemGetPipeStat(char* const nodeName,char* const pipeName,NODE_PIPE_STAT* stat);
 void nodeSystemExit();
 #else
 int nodeSystemLoop();
@@ -103,8 +226,18 @@ int nodeSystemBegine();
 void nodeSystemDebugLog(char* const str);
 int nodeStstemSetDebugMode(NODE_DEBUG_MODE mode);
 int nodeSystemRead(int pipeID,void* buffer);
+int nodeSystemReadInfo(int pipeID,void* buffer,NODE_PIPE_INFO* info);
 int nodeSystemWrite(int pipeID,void* const buffer);
 int nodeSystemAddPipe(char* const pipeName,NODE_PIPE_TYPE type,NODE_DATA_UNIT unit,uint16_t arrayLength,const void* buff);
+int nodeSystemAddStreamPipe(char* const pipeName,NODE_DATA_UNIT unit,uint16_t arrayLength,uint16_t depth);
+int nodeSystemReadStream(int pipeID,void* buffer,uint16_t maxCount);
+int nodeSystemReadMerge(int pipeID,void* buffer,uint16_t maxCount,uint8_t* isUpdated);
+//write loan: NODE_PIPE_STREAM or OUT with NODE_PIPE_OPT_TRIPLE/NODE_PIPE_OPT_SEMAPHORE
+void* nodeSystemWriteAcquire(int pipeID);
+int nodeSystemWriteCommit(int pipeID);
+const void* nodeSystemReadAcquire(int pipeID,int* isUpdated);
+int nodeSystemReadRelease(int pipeID);
 int nodeSystemWait();
+int nodeSystemWaitInput(double timeout);
 double nodeSystemGetPeriod();
 #endif
\ No newline at end of file